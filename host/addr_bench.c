@@ -0,0 +1,148 @@
+//addr.c against the libc parser and formatter on the same addresses.
+//
+//  addr_bench [COUNT]          parse and format COUNT generated addresses,
+//                              print ns per address for both
+//
+//the set mixes what profile files hold: dotted quads, compressed v6, full
+//v6 with leading zeros and v4-mapped. every address is checked against
+//inet_pton first, so a fast wrong answer fails the run instead
+
+#include "addr.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+
+#define BENCH_DEFAULT_COUNT 100000
+#define BENCH_RUNS          5
+
+static char (*texts)[ADDR_STRLEN];
+static size_t *lens;
+static addr_t *addrs;
+static volatile size_t sink; //keeps the timed loops from being dropped
+
+static double seconds_since(const struct timespec *a) {
+    struct timespec b;
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    return (b.tv_sec - a->tv_sec) + (b.tv_nsec - a->tv_nsec) / 1e9;
+}
+
+static void make_text(unsigned int i, char *out) {
+    unsigned int a = (i * 2654435761u) >> 8;
+    switch (i % 4) {
+        case 0: snprintf(out, ADDR_STRLEN, "%u.%u.%u.%u", 1 + (a & 127), (a >> 7) & 255, (a >> 15) & 255, i & 255); break;
+        case 1: snprintf(out, ADDR_STRLEN, "2001:db8::%x:%x", a & 0xFFFF, i & 0xFFFF); break;
+        case 2: snprintf(out, ADDR_STRLEN, "2606:4700:%04x:0000:0000:%04x:6810:%04x", a & 0xFFFF, (a >> 8) & 0xFFFF, i & 0xFFFF); break;
+        default: snprintf(out, ADDR_STRLEN, "::ffff:10.%u.%u.%u", (a >> 16) & 255, (a >> 8) & 255, i & 255); break;
+    }
+}
+
+static int is_v6_text(const char *text) {
+    return strchr(text, ':') != NULL;
+}
+
+//best of BENCH_RUNS, in ns per address
+static double time_addr_parse(size_t count) {
+    double best = 1e9;
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        size_t n = 0;
+        for (size_t i = 0; i < count; i++) n += addr_parse(texts[i], lens[i], &addrs[i]);
+        double s = seconds_since(&t);
+        sink = n;
+        if (s < best) best = s;
+    }
+    return best * 1e9 / count;
+}
+
+static double time_inet_pton(size_t count) {
+    double best = 1e9;
+    uint8_t bytes[16];
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        size_t n = 0;
+        for (size_t i = 0; i < count; i++) {
+            n += inet_pton(is_v6_text(texts[i]) ? AF_INET6 : AF_INET, texts[i], bytes);
+        }
+        double s = seconds_since(&t);
+        sink = n + bytes[0];
+        if (s < best) best = s;
+    }
+    return best * 1e9 / count;
+}
+
+static double time_addr_format(size_t count) {
+    double best = 1e9;
+    char out[ADDR_STRLEN];
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        size_t n = 0;
+        for (size_t i = 0; i < count; i++) n += addr_format(&addrs[i], out, sizeof(out));
+        double s = seconds_since(&t);
+        sink = n;
+        if (s < best) best = s;
+    }
+    return best * 1e9 / count;
+}
+
+static double time_inet_ntop(size_t count) {
+    double best = 1e9;
+    char out[INET6_ADDRSTRLEN];
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        struct timespec t;
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        size_t n = 0;
+        for (size_t i = 0; i < count; i++) {
+            int af = addrs[i].family == ADDR_V6 ? AF_INET6 : AF_INET;
+            n += inet_ntop(af, addrs[i].bytes, out, sizeof(out)) != NULL;
+        }
+        double s = seconds_since(&t);
+        sink = n;
+        if (s < best) best = s;
+    }
+    return best * 1e9 / count;
+}
+
+int main(int argc, char **argv) {
+    size_t count = argc >= 2 ? (size_t)atoi(argv[1]) : BENCH_DEFAULT_COUNT;
+    if (!count) count = BENCH_DEFAULT_COUNT;
+
+    texts = malloc(count * sizeof(*texts));
+    lens = malloc(count * sizeof(*lens));
+    addrs = malloc(count * sizeof(*addrs));
+    if (!texts || !lens || !addrs) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        make_text((unsigned int)i, texts[i]);
+        lens[i] = strlen(texts[i]);
+
+        uint8_t bytes[16];
+        int v6 = is_v6_text(texts[i]);
+        int want = v6 ? ADDR_V6 : ADDR_V4;
+        if (addr_parse(texts[i], lens[i], &addrs[i]) != want ||
+            inet_pton(v6 ? AF_INET6 : AF_INET, texts[i], bytes) != 1 ||
+            memcmp(addrs[i].bytes, bytes, v6 ? 16 : 4) != 0) {
+            fprintf(stderr, "%s: addr_parse and inet_pton disagree\n", texts[i]);
+            return 1;
+        }
+    }
+
+    double parse = time_addr_parse(count), pton = time_inet_pton(count);
+    double format = time_addr_format(count), ntop = time_inet_ntop(count);
+    printf("%zu addresses, a quarter each v4, short v6, full v6, v4-mapped\n", count);
+    printf("parse   addr_parse %6.1f ns   inet_pton %6.1f ns   %4.1fx\n", parse, pton, pton / parse);
+    printf("format  addr_format %5.1f ns   inet_ntop %6.1f ns   %4.1fx\n", format, ntop, ntop / format);
+
+    free(texts);
+    free(lens);
+    free(addrs);
+    return 0;
+}
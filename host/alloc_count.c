@@ -0,0 +1,59 @@
+//heap accounting for the replay: the Makefile links with --wrap for every
+//allocator entry point the sources call, so each block main.c and the
+//modules take is counted and blocks still live at exit are leaks. libc's
+//own allocations (stdio, threads) go to the real malloc and aren't counted
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+static uint64_t alloc_total = 0;    //blocks handed out, realloc growth included
+static int64_t alloc_live = 0;
+
+//the persister and the commit worker allocate too
+#define COUNT(var, n)   __atomic_add_fetch(&(var), (n), __ATOMIC_RELAXED)
+
+void *__wrap_malloc(size_t size) {
+    void *p = __real_malloc(size);
+    if (p) COUNT(alloc_total, 1), COUNT(alloc_live, 1);
+    return p;
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    void *p = __real_calloc(count, size);
+    if (p) COUNT(alloc_total, 1), COUNT(alloc_live, 1);
+    return p;
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    void *p = __real_realloc(ptr, size);
+    if (!p) return NULL;
+    COUNT(alloc_total, 1);
+    if (!ptr) COUNT(alloc_live, 1);
+    return p;
+}
+
+void __wrap_free(void *ptr) {
+    if (ptr) COUNT(alloc_live, -1);
+    __real_free(ptr);
+}
+
+char *__wrap_strdup(const char *str) {
+    size_t len = strlen(str) + 1;
+    char *p = __wrap_malloc(len);
+    if (p) memcpy(p, str, len);
+    return p;
+}
+
+uint64_t alloc_count(void) {
+    return __atomic_load_n(&alloc_total, __ATOMIC_RELAXED);
+}
+
+int64_t alloc_live_count(void) {
+    return __atomic_load_n(&alloc_live, __ATOMIC_RELAXED);
+}
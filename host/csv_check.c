@@ -0,0 +1,264 @@
+//csv.h against the corpus in host/csv, and its throughput.
+//
+//  csv_check csv/              every NAME.csv must parse to NAME.expect
+//  csv_check -b [MB]           parse MB of generated profile rows, print MB/s
+//
+//.expect files hold one line per row, each field in brackets with \r, \n,
+//\\ and \] escaped, so "a,,b" is [a][][b] and a blank line is an empty row
+
+#include "csv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_MB    64
+
+static const char *tmp_path = "csv_check.tmp";
+
+typedef struct {
+    CSVBuffer out;
+    size_t fields;
+    size_t rows;
+} Render;
+
+static int render_field(const char *field, size_t len, size_t col, void *ctx) {
+    Render *r = ctx;
+    if (!csv_buffer_reserve(&r->out, len * 2 + 2)) return 0;
+    r->out.data[r->out.len++] = '[';
+    for (size_t i = 0; i < len; i++) {
+        char c = field[i];
+        if (c == '\r' || c == '\n' || c == '\\' || c == ']') {
+            r->out.data[r->out.len++] = '\\';
+            c = c == '\r' ? 'r' : c == '\n' ? 'n' : c;
+        }
+        r->out.data[r->out.len++] = c;
+    }
+    r->out.data[r->out.len++] = ']';
+    r->fields++;
+    return 1;
+}
+
+static int render_row(size_t row, size_t field_count, void *ctx) {
+    Render *r = ctx;
+    if (!csv_buffer_reserve(&r->out, 1)) return 0;
+    r->out.data[r->out.len++] = '\n';
+    r->rows++;
+    return 1;
+}
+
+static char *read_file(const char *path, size_t *len) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return NULL;
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *data = malloc(size + 1);
+    if (data && fread(data, 1, size, fp) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(fp);
+    if (data) {
+        data[size] = '\0';
+        *len = size;
+    }
+    return data;
+}
+
+static int write_file(const char *path, const char *data, size_t len) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) return 0;
+    size_t written = fwrite(data, 1, len, fp);
+    return fclose(fp) == 0 && written == len;
+}
+
+static int check_rendered(const char *name, const char *path, const char *expect_path) {
+    Render r;
+    memset(&r, 0, sizeof(r));
+    if (!csv_parse_stream(path, ',', render_field, render_row, &r)) {
+        printf("FAIL %s: parse failed\n", name);
+        csv_buffer_free(&r.out);
+        return 0;
+    }
+
+    size_t expect_len;
+    char *expect = read_file(expect_path, &expect_len);
+    int ok = expect && expect_len == r.out.len && memcmp(expect, r.out.data, r.out.len) == 0;
+    if (!ok) {
+        printf("FAIL %s\n--- expected\n%s--- got\n%.*s---\n", name,
+               expect ? expect : "(missing)\n", (int)r.out.len, r.out.data);
+    } else {
+        printf("ok   %s\n", name);
+    }
+    free(expect);
+    csv_buffer_free(&r.out);
+    return ok;
+}
+
+//a quoted field longer than the stream chunk, with escapes on both sides
+//of the refill boundary
+static int check_long_field(void) {
+    size_t body = CSV_STREAM_CHUNK + 1000;
+    CSVBuffer in = {0}, want = {0};
+    if (!csv_buffer_reserve(&in, body * 2 + 64) || !csv_buffer_reserve(&want, body * 3 + 64)) return 0;
+
+    memcpy(in.data, "head,\"", 6);
+    in.len = 6;
+    memcpy(want.data, "[head][", 7);
+    want.len = 7;
+    for (size_t i = 0; i < body; i++) {
+        char c = "abc\"\n,"[i % 6];
+        in.data[in.len++] = c;
+        if (c == '"') in.data[in.len++] = '"';
+        if (c == '\n') want.data[want.len++] = '\\', c = 'n';
+        want.data[want.len++] = c;
+    }
+    memcpy(in.data + in.len, "\",tail\n", 7);
+    in.len += 7;
+    memcpy(want.data + want.len, "][tail]\n", 8);
+    want.len += 8;
+
+    Render r;
+    memset(&r, 0, sizeof(r));
+    int ok = write_file(tmp_path, in.data, in.len) &&
+             csv_parse_stream(tmp_path, ',', render_field, render_row, &r) &&
+             r.out.len == want.len && memcmp(r.out.data, want.data, want.len) == 0;
+    printf("%s long quoted field across a refill\n", ok ? "ok  " : "FAIL");
+    remove(tmp_path);
+    csv_buffer_free(&in);
+    csv_buffer_free(&want);
+    csv_buffer_free(&r.out);
+    return ok;
+}
+
+//whatever csv_buffer_add_row writes has to come back field for field
+static int check_round_trip(void) {
+    char *fields[] = {"plain", "", "com,ma", "quo\"te", "cr\rlf\n", "\"\"", " spaced "};
+    const size_t count = sizeof(fields) / sizeof(fields[0]);
+
+    CSVBuffer file = {0};
+    for (int i = 0; i < 3; i++) {
+        if (!csv_buffer_add_row(&file, fields, count, ',')) return 0;
+    }
+
+    Render r;
+    memset(&r, 0, sizeof(r));
+    int ok = write_file(tmp_path, file.data, file.len) &&
+             csv_parse_stream(tmp_path, ',', render_field, render_row, &r) &&
+             r.rows == 3 && r.fields == 3 * count;
+    if (ok) {
+        Render want;
+        memset(&want, 0, sizeof(want));
+        for (int i = 0; i < 3; i++) {
+            for (size_t f = 0; f < count; f++) render_field(fields[f], strlen(fields[f]), f, &want);
+            render_row(i, count, &want);
+        }
+        ok = want.out.len == r.out.len && memcmp(want.out.data, r.out.data, r.out.len) == 0;
+        csv_buffer_free(&want.out);
+    }
+    printf("%s writer round trip\n", ok ? "ok  " : "FAIL");
+    remove(tmp_path);
+    csv_buffer_free(&file);
+    csv_buffer_free(&r.out);
+    return ok;
+}
+
+static int run_corpus(const char *dir) {
+    struct dirent **ents;
+    int n = scandir(dir, &ents, NULL, alphasort);
+    if (n < 0) {
+        fprintf(stderr, "csv_check: can't open %s\n", dir);
+        return 1;
+    }
+
+    int failed = 0, cases = 0;
+    for (int i = 0; i < n; i++) {
+        const char *name = ents[i]->d_name;
+        size_t len = strlen(name);
+        if (len > 4 && strcmp(name + len - 4, ".csv") == 0) {
+            char path[512], expect[512];
+            snprintf(path, sizeof(path), "%s/%s", dir, name);
+            snprintf(expect, sizeof(expect), "%s/%.*s.expect", dir, (int)(len - 4), name);
+            cases++;
+            if (!check_rendered(name, path, expect)) failed++;
+        }
+        free(ents[i]);
+    }
+    free(ents);
+
+    cases += 2;
+    if (!check_long_field()) failed++;
+    if (!check_round_trip()) failed++;
+
+    printf("%d/%d passed\n", cases - failed, cases);
+    return failed ? 1 : 0;
+}
+
+static int count_field(const char *field, size_t len, size_t col, void *ctx) {
+    ((size_t *)ctx)[0] += len;
+    return 1;
+}
+
+static int count_row(size_t row, size_t field_count, void *ctx) {
+    ((size_t *)ctx)[1]++;
+    return 1;
+}
+
+static double parse_seconds(size_t *bytes, size_t *rows) {
+    size_t counts[2] = {0, 0};
+    struct timespec a, b;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    csv_parse_stream(tmp_path, ',', count_field, count_row, counts);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    *bytes = counts[0];
+    *rows = counts[1];
+    return (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+//profile-shaped rows, once plain and once with every text field quoted
+static int run_bench(size_t mb) {
+    static const char *names[] = {"Cloudflare", "Google", "Quad9", "AdGuard DNS", "OpenDNS Home"};
+    const char *styles[] = {"unquoted", "quoted"};
+
+    for (int quoted = 0; quoted < 2; quoted++) {
+        CSVBuffer file = {0};
+        char name[64], primary[32], secondary[32], tags[64];
+        for (unsigned int i = 0; file.len < mb * 1024 * 1024; i++) {
+            snprintf(name, sizeof(name), quoted ? "%s, \"%u\"" : "%s %u", names[i % 5], i);
+            snprintf(primary, sizeof(primary), "10.%u.%u.%u", (i >> 16) & 255, (i >> 8) & 255, i & 255);
+            snprintf(secondary, sizeof(secondary), "2001:db8::%x", i & 0xFFFF);
+            snprintf(tags, sizeof(tags), quoted ? "fast;\"home\"" : "fast;home");
+            char *fields[] = {name, primary, secondary, "Public", tags, ""};
+            if (!csv_buffer_add_row(&file, fields, 6, ',')) return 1;
+        }
+        if (!write_file(tmp_path, file.data, file.len)) return 1;
+
+        size_t bytes, rows;
+        parse_seconds(&bytes, &rows); //warm the page cache
+        double best = 1e9;
+        for (int run = 0; run < 5; run++) {
+            double t = parse_seconds(&bytes, &rows);
+            if (t < best) best = t;
+        }
+        printf("%-8s %7.1f MB  %9zu rows  %7.1f MB/s\n", styles[quoted],
+               file.len / 1048576.0, rows, file.len / 1048576.0 / best);
+        csv_buffer_free(&file);
+    }
+    remove(tmp_path);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "-b") == 0) {
+        size_t mb = argc >= 3 ? (size_t)atoi(argv[2]) : BENCH_DEFAULT_MB;
+        return run_bench(mb ? mb : BENCH_DEFAULT_MB);
+    }
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s CORPUS_DIR | -b [MB]\n", argv[0]);
+        return 2;
+    }
+    return run_corpus(argv[1]);
+}
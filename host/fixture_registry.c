@@ -0,0 +1,67 @@
+//minimal xRegistry.sys files for the host builds: the replay writes the
+//fixture under ROOT when it's missing, the tests build theirs to load
+
+#include "fixture_registry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void put16(uint8_t *p, unsigned int v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+int write_registry_keys(const char *path, const fixture_key_t *keys, size_t count) {
+    static const uint8_t end_marker[7] = {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0x00, 0x00};
+    const size_t size = 0x40000, key_header = 0x10;
+
+    uint8_t *buf = calloc(size, 1);
+    if (!buf) return 0;
+    size_t kp = key_header, vp = 0x10000;
+    for (size_t i = 0; i < count; i++) {
+        size_t name_len = strlen(keys[i].name);
+        put16(buf + kp + 2, (unsigned int)name_len);
+        buf[kp + 4] = keys[i].type;
+        memcpy(buf + kp + 5, keys[i].name, name_len);
+
+        put16(buf + vp + 2, (unsigned int)(kp - key_header));
+        put16(buf + vp + 6, keys[i].length);
+        buf[vp + 8] = keys[i].type;
+        if (keys[i].type == 2) {
+            if (keys[i].text) memcpy(buf + vp + 9, keys[i].text, strlen(keys[i].text));
+        } else {
+            for (int b = 0; b < keys[i].length; b++) {
+                buf[vp + 9 + b] = (uint8_t)(keys[i].number >> (8 * (keys[i].length - 1 - b)));
+            }
+        }
+
+        kp += 5 + name_len + 1;
+        vp += 9 + keys[i].length + 1;
+    }
+    memcpy(buf + kp, end_marker, sizeof(end_marker));
+    memcpy(buf + vp, end_marker, sizeof(end_marker));
+
+    FILE *f = fopen(path, "wb");
+    int ok = f && fwrite(buf, 1, size, f) == size;
+    if (f && fclose(f) != 0) ok = 0;
+    free(buf);
+    return ok;
+}
+
+int write_fixture_registry(const char *path) {
+    static const fixture_key_t keys[] = {
+        {"/setting/net/dnsFlag",         1, 4,   NULL, 0},
+        {"/setting/net/primaryDns",      2, 16,  "", 0},
+        {"/setting/net/secondaryDns",    2, 16,  "", 0},
+        {"/setting/net/ipAddressFlag",   1, 4,   NULL, 0},
+        {"/setting/net/ipAddress",       2, 16,  "192.168.1.20", 0},
+        {"/setting/net/netmask",         2, 16,  "255.255.255.0", 0},
+        {"/setting/net/defaultRoute",    2, 16,  "192.168.1.1", 0},
+        {"/setting/net/mtu",             1, 4,   NULL, 1500},
+        {"/setting/net/httpProxyFlag",   1, 4,   NULL, 0},
+        {"/setting/net/httpProxyServer", 2, 128, "", 0},
+        {"/setting/net/httpProxyPort",   1, 4,   NULL, 0},
+    };
+    return write_registry_keys(path, keys, sizeof(keys) / sizeof(keys[0]));
+}
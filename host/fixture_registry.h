@@ -0,0 +1,23 @@
+#ifndef FIXTURE_REGISTRY_H
+#define FIXTURE_REGISTRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//one key of a host registry file. strings take text, numbers take number
+//big endian in length bytes
+typedef struct {
+    const char *name;
+    uint8_t type;       //0 bool, 1 int, 2 string
+    uint16_t length;
+    const char *text;
+    uint32_t number;
+} fixture_key_t;
+
+//an xRegistry.sys holding exactly these keys. 0 if it can't be written
+int write_registry_keys(const char *path, const fixture_key_t *keys, size_t count);
+
+//just the keys main.c reads and captures, dns on automatic
+int write_fixture_registry(const char *path);
+
+#endif
@@ -0,0 +1,626 @@
+//unit tests for the button handlers. main.c is compiled into this file so
+//its state is visible; input, the keyboard and the platform are fakes, so
+//each test queues pad events, runs them through dispatch_input and checks
+//the state and cursor they leave behind. no window; the apply tests load
+//the host fixture registry (fixture_registry.c), the rest run without one
+//
+//  make -C host test
+
+#define main ezdns_main
+#include "../source/main.c"
+#undef main
+
+#include "fixture_registry.h"
+
+#define TEST_PROFILE_PATH   "handlers_test.csv"
+#define TEST_REGISTRY_PATH  "handlers_test.sys"
+#define TEST_QUEUE_SIZE     64
+
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    checks++; \
+    if (!(cond)) { \
+        failures++; \
+        printf("  %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+} while (0)
+
+//input.c: a queue the tests fill, held buttons as a real poll would see them
+static input_event_t test_queue[TEST_QUEUE_SIZE];
+static int test_queue_head = 0;
+static int test_queue_count = 0;
+static uint32_t test_held = 0;
+static int test_scroll = 0;
+
+void input_init(const input_config_t *config) {}
+void input_end(void) {}
+void input_poll(void) {}
+
+int input_next(input_event_t *event) {
+    if (test_queue_head == test_queue_count) return 0;
+    *event = test_queue[test_queue_head++];
+    return 1;
+}
+
+uint32_t input_held(void) {
+    return test_held;
+}
+
+int input_scroll(void) {
+    int rows = test_scroll;
+    test_scroll = 0;
+    return rows;
+}
+
+static void queue_event(input_event_type_t type, input_button_t button) {
+    if (test_queue_count == TEST_QUEUE_SIZE) return;
+    if (type == INPUT_PRESS) test_held |= INPUT_BIT(button);
+    if (type == INPUT_RELEASE) test_held &= ~INPUT_BIT(button);
+    test_queue[test_queue_count++] = (input_event_t){type, button};
+}
+
+//one frame: everything queued goes through dispatch_input
+static void run_frame(void) {
+    dispatch_input();
+    test_queue_head = test_queue_count = 0;
+}
+
+static void press(input_button_t button) {
+    queue_event(INPUT_PRESS, button);
+    run_frame();
+}
+
+static void release(input_button_t button) {
+    queue_event(INPUT_RELEASE, button);
+    run_frame();
+}
+
+static void tap(input_button_t button) {
+    press(button);
+    release(button);
+}
+
+static void tap_n(input_button_t button, int n) {
+    while (n-- > 0) tap(button);
+}
+
+//osk.h: osk_begin opens it, finish_osk or cancel_osk closes it
+static char *test_osk_dest = NULL;
+static int test_osk_size = 0;
+static int test_osk_state = OSK_EDIT_NONE;
+
+int osk_session_open(void) { return 1; }
+void osk_session_close(void) {}
+
+int osk_begin(const char *caption, char *str, int len) {
+    if (test_osk_state != OSK_EDIT_NONE) return 0;
+    test_osk_dest = str;
+    test_osk_size = len;
+    test_osk_state = OSK_EDIT_PENDING;
+    return 1;
+}
+
+int osk_poll(void) {
+    int state = test_osk_state;
+    if (state == OSK_EDIT_DONE || state == OSK_EDIT_CANCELED) test_osk_state = OSK_EDIT_NONE;
+    return state;
+}
+
+int osk_active(void) {
+    return test_osk_state != OSK_EDIT_NONE;
+}
+
+static void finish_osk(const char *text) {
+    snprintf(test_osk_dest, test_osk_size, "%s", text);
+    test_osk_state = OSK_EDIT_DONE;
+    poll_osk_edit();
+}
+
+static void cancel_osk(void) {
+    test_osk_state = OSK_EDIT_CANCELED;
+    poll_osk_edit();
+}
+
+//platform.h: nothing is drawn, the clock only moves when a test says so
+static uint64_t test_clock_us = 1;
+
+void platform_init(int argc, char **argv) {}
+int platform_running(void) { return 1; }
+uint64_t platform_time_us(void) { return test_clock_us; }
+void platform_idle(uint32_t us) { test_clock_us += us; }
+void platform_set_background(int (*busy)(void)) {}
+void platform_gfx_init(void) {}
+void platform_font_init(void) {}
+void platform_clear(uint32_t color) {}
+void platform_flip(void) {}
+void platform_quad(float x, float y, float w, float h, uint32_t color, float z) {}
+float platform_text(float x, float y, const char *str) { return x; }
+float platform_textf(float x, float y, const char *fmt, ...) { return x; }
+void platform_text_color(uint32_t color, uint32_t bkcolor) {}
+void platform_text_center(int on) {}
+void platform_pad_init(void) {}
+void platform_pad_end(void) {}
+int platform_pad_read(int port, platform_pad_t *pad) { return 0; }
+void platform_net_init(void) {}
+void platform_poll_system(void) {}
+int platform_overlay_open(void) { return 0; }
+void platform_ring_buzzer(int beeps) {}
+int platform_soft_reboot(void) { return 0; }
+void platform_exit(void) {}
+void netDebugInit() {}
+void netDebug(const char *fmt, ...) {}
+
+//the two pinned rows and five profiles in file order, odd rows in "Odd",
+//even ones in "Even"
+static const char *test_names[] = {"Alpha", "Bravo", "Charlie", "Delta", "Echo"};
+#define TEST_PROFILES   5
+#define TEST_ROWS       (TEST_PROFILES + 2)
+
+static void reset(void) {
+    free_saved_values();
+    search_buf[0] = '\0';
+    search_len = 0;
+    search_wheel_pos = 0;
+    sortOrder = SORT_FILE;
+    currentState = STATE_NO_DIALOG;
+    cur_pos = 0;
+    table_scroll = 0;
+    cur_pos_new_profile_dialog = 0;
+    reset_new_profile_form();
+    exit_requested = 0;
+    test_held = 0;
+
+    make_profile(&currentValues, "Current", DNS_FLAG_MANUAL, "1.1.1.1", "1.0.0.1", "", "");
+    modifiedValues = currentValues;
+    add_saved_value(&savedValueList, &savedValueCount, currentValues);
+    Values profile;
+    make_profile(&profile, "System Default", DNS_FLAG_AUTOMATIC, "", "", "", "");
+    add_saved_value(&savedValueList, &savedValueCount, profile);
+    for (int i = 0; i < TEST_PROFILES; i++) {
+        char primary[16];
+        snprintf(primary, sizeof(primary), "10.0.0.%d", i + 1);
+        make_profile(&profile, test_names[i], DNS_FLAG_MANUAL, primary, "10.0.1.1", i % 2 ? "Even" : "Odd", "");
+        add_saved_value(&savedValueList, &savedValueCount, profile);
+    }
+    refresh_view();
+    set_cursor(0);
+}
+
+static const char *cursor_name(void) {
+    return view_count() > 0 ? savedValueList[view_index(cur_pos)].name : "";
+}
+
+static void test_cursor_wraps(void) {
+    tap_n(INPUT_DOWN, 2);
+    CHECK(cur_pos == 2);
+    CHECK(strcmp(curPosValues.name, "Alpha") == 0);
+    tap_n(INPUT_UP, 3);
+    CHECK(cur_pos == TEST_ROWS - 1); //a press past the top wraps
+    tap(INPUT_DOWN);
+    CHECK(cur_pos == 0);
+    CHECK(currentState == STATE_NO_DIALOG);
+}
+
+static void test_repeat_stops_at_the_ends(void) {
+    tap(INPUT_R2);
+    CHECK(cur_pos == TEST_ROWS - 1);
+    queue_event(INPUT_REPEAT, INPUT_DOWN);
+    run_frame();
+    CHECK(cur_pos == TEST_ROWS - 1); //holding doesn't wrap
+    tap(INPUT_L2);
+    queue_event(INPUT_REPEAT, INPUT_UP);
+    run_frame();
+    CHECK(cur_pos == 0);
+    tap(INPUT_R1);
+    CHECK(cur_pos == TEST_ROWS - 1); //a page is taller than the list, clamped
+    tap(INPUT_L1);
+    CHECK(cur_pos == 0);
+}
+
+static void test_stick_scrolls_only_the_table(void) {
+    test_scroll = 3;
+    run_frame();
+    CHECK(cur_pos == 3);
+    test_scroll = 100;
+    run_frame();
+    CHECK(cur_pos == TEST_ROWS - 1);
+    tap(INPUT_START);
+    test_scroll = -2;
+    run_frame();
+    CHECK(currentState == STATE_NEW_PROFILE_DIALOG);
+    CHECK(cur_pos == TEST_ROWS - 1);
+}
+
+static void test_confirm_and_cancel(void) {
+    tap(INPUT_CROSS);
+    CHECK(currentState == STATE_NO_DIALOG); //"Current" can't be applied
+    tap_n(INPUT_DOWN, 3);
+    tap(INPUT_CROSS);
+    CHECK(currentState == STATE_CONFIRMATION_DIALOG);
+    CHECK(strcmp(modifiedValues.name, "Bravo") == 0);
+    tap(INPUT_DOWN);
+    CHECK(cur_pos == 3); //the table doesn't move under a dialog
+    tap(INPUT_CIRCLE);
+    CHECK(currentState == STATE_NO_DIALOG);
+    CHECK(strcmp(modifiedValues.name, "Current") == 0);
+}
+
+static void test_apply_failure_is_recoverable(void) {
+    tap_n(INPUT_DOWN, 2);
+    tap(INPUT_CROSS);
+    tap(INPUT_CROSS); //no registry loaded, so the plan is invalid
+    CHECK(currentState == STATE_ERROR_DIALOG);
+    CHECK(applyingName[0] == '\0');
+    CHECK(savedValueList[2].useCount == 0); //a failed apply isn't a use
+    tap(INPUT_CROSS);
+    CHECK(currentState == STATE_ERROR_DIALOG);
+    tap(INPUT_SQUARE);
+    CHECK(currentState == STATE_NO_DIALOG);
+}
+
+static void test_delete(void) {
+    tap(INPUT_CIRCLE);
+    CHECK(currentState == STATE_NO_DIALOG); //pinned rows stay
+    tap(INPUT_DOWN);
+    tap(INPUT_CIRCLE);
+    CHECK(currentState == STATE_NO_DIALOG);
+    tap_n(INPUT_DOWN, 2);
+    tap(INPUT_CIRCLE);
+    CHECK(currentState == STATE_DELETION_CONFIRMATION_DIALOG);
+    tap(INPUT_CIRCLE);
+    CHECK(currentState == STATE_NO_DIALOG);
+    CHECK(savedValueCount == TEST_ROWS);
+    tap(INPUT_CIRCLE);
+    tap(INPUT_CROSS);
+    CHECK(currentState == STATE_NO_DIALOG);
+    CHECK(savedValueCount == TEST_ROWS - 1);
+    CHECK(!nameset_contains(&savedNames, "Bravo"));
+    CHECK(cur_pos == 0);
+}
+
+static void test_new_profile_form(void) {
+    tap(INPUT_START);
+    CHECK(currentState == STATE_NEW_PROFILE_DIALOG);
+    tap(INPUT_CROSS);
+    CHECK(currentState == STATE_OSK);
+    tap(INPUT_SQUARE);
+    CHECK(currentState == STATE_OSK); //the keyboard has the pads
+    finish_osk("Foxtrot");
+    CHECK(currentState == STATE_NEW_PROFILE_DIALOG);
+    tap(INPUT_DOWN);
+    tap(INPUT_CROSS);
+    finish_osk("10.0.0.6");
+    tap(INPUT_DOWN);
+    tap(INPUT_CROSS);
+    cancel_osk();
+    CHECK(currentState == STATE_NEW_PROFILE_DIALOG);
+    tap(INPUT_SQUARE);
+    CHECK(currentState == STATE_ERROR_DIALOG); //secondary still empty
+    tap(INPUT_SQUARE);
+    CHECK(currentState == STATE_NO_DIALOG);
+    CHECK(savedValueCount == TEST_ROWS);
+
+    tap(INPUT_START);
+    CHECK(cur_pos_new_profile_dialog == 2); //the form keeps its place
+    tap(INPUT_CROSS);
+    finish_osk("10.0.0.7");
+    tap(INPUT_SQUARE);
+    CHECK(currentState == STATE_NO_DIALOG);
+    CHECK(savedValueCount == TEST_ROWS + 1);
+    CHECK(nameset_contains(&savedNames, "foxtrot"));
+
+    tap(INPUT_START);
+    int field = cur_pos_new_profile_dialog;
+    tap_n(INPUT_UP, field + 2);
+    CHECK(cur_pos_new_profile_dialog == NEW_PROFILE_FIELD_COUNT - 2); //wraps past the first field
+    tap(INPUT_CIRCLE);
+    CHECK(currentState == STATE_NO_DIALOG);
+    CHECK(cur_pos_new_profile_dialog == 0);
+}
+
+static void test_search(void) {
+    tap(INPUT_R3);
+    CHECK(currentState == STATE_SEARCH);
+    tap(INPUT_RIGHT); //wheel starts on 'a'
+    CHECK(view_count() == 1);
+    CHECK(strcmp(cursor_name(), "Alpha") == 0);
+    tap(INPUT_DOWN);
+    tap(INPUT_RIGHT); //"ab"
+    CHECK(view_count() == 0);
+    tap(INPUT_LEFT);
+    CHECK(view_count() == 1);
+    tap(INPUT_CROSS); //keep the filter
+    CHECK(currentState == STATE_NO_DIALOG);
+    CHECK(view_count() == 1);
+    tap(INPUT_DOWN);
+    CHECK(cur_pos == 0);
+
+    tap(INPUT_R3);
+    tap(INPUT_SQUARE);
+    CHECK(currentState == STATE_OSK);
+    finish_osk("d");
+    CHECK(currentState == STATE_SEARCH);
+    CHECK(strcmp(cursor_name(), "Delta") == 0);
+    tap(INPUT_CIRCLE);
+    CHECK(currentState == STATE_NO_DIALOG);
+    CHECK(view_count() == TEST_ROWS);
+}
+
+static void test_labels(void) {
+    tap(INPUT_RIGHT);
+    int first = view_count();
+    tap(INPUT_RIGHT);
+    int second = view_count();
+    CHECK(first + second == TEST_PROFILES);
+    CHECK(first > 0 && second > 0);
+    tap(INPUT_RIGHT);
+    CHECK(view_count() == TEST_ROWS); //back to every profile
+    tap(INPUT_LEFT);
+    CHECK(view_count() == second);
+    CHECK(cur_pos == 0);
+}
+
+static void test_profiler_combo(void) {
+    int was_on = prof_on;
+    SortOrder sort = sortOrder;
+    press(INPUT_L3);
+    press(INPUT_R3);
+    CHECK(prof_on != was_on);
+    release(INPUT_R3);
+    release(INPUT_L3);
+    CHECK(sortOrder == sort); //the clicks were swallowed
+    CHECK(currentState == STATE_NO_DIALOG);
+
+    tap(INPUT_L3);
+    CHECK(sortOrder == (sort + 1) % SORT_ORDER_COUNT);
+    press(INPUT_L3);
+    press(INPUT_R3);
+    release(INPUT_L3);
+    release(INPUT_R3);
+    CHECK(prof_on == was_on);
+}
+
+static void test_exit(void) {
+    tap(INPUT_TRIANGLE);
+    tap(INPUT_SELECT);
+    CHECK(currentState == STATE_SAVE_DIALOG); //dns mode changed, ask first
+    CHECK(!exit_requested);
+    tap(INPUT_CIRCLE);
+    CHECK(currentState == STATE_NO_DIALOG);
+    tap(INPUT_TRIANGLE);
+    tap(INPUT_SELECT);
+    CHECK(exit_requested);
+}
+
+//a profile file write that fails while the restart dialog waits on the
+//registry commit must not take the dialog down before the reboot
+static void test_persist_error_waits_for_restart(void) {
+    remove(TEST_PROFILE_PATH);
+    mkdir(TEST_PROFILE_PATH, 0755); //opens, but every read fails
+    persist_remove("Alpha");
+    while(!persist_idle()) usleep(1000);
+    rmdir(TEST_PROFILE_PATH);
+
+    currentState = STATE_RESTART_DIALOG;
+    poll_persist_errors(NULL);
+    CHECK(currentState == STATE_RESTART_DIALOG);
+    currentState = STATE_NO_DIALOG;
+    poll_persist_errors(NULL);
+    CHECK(currentState == STATE_ERROR_DIALOG);
+    CHECK(strcmp(el2, "Could not read the profile file.") == 0);
+}
+
+//dns on automatic with both servers empty, like a fresh console
+static xreg_registry_t *load_test_registry(void) {
+    if (!write_fixture_registry(TEST_REGISTRY_PATH)) return NULL;
+    xreg_registry_t *reg = xreg_load(TEST_REGISTRY_PATH);
+    remove(TEST_REGISTRY_PATH);
+    return reg;
+}
+
+static void test_registry_plan(void) {
+    xreg_registry_t *reg = load_test_registry();
+    CHECK(reg != NULL);
+    if (!reg) return;
+    RegistryPlan plan;
+
+    make_profile(&modifiedValues, "Bravo", DNS_FLAG_MANUAL, "10.0.0.2", "10.0.1.1", "", "");
+    CHECK(profile_set_settings(&modifiedValues, "mtu=1400") == SUCCESS);
+    CHECK(plan_modified_values(reg, &plan) == APPLY_REBOOT);
+    CHECK(plan.count == 4); //settings first, the dns keys last so they win
+    CHECK(strcmp(plan.writes[0].key_name, "/setting/net/mtu") == 0);
+    CHECK(strcmp(plan.writes[1].key_name, DNS_FLAG_KEY) == 0 && strcmp(plan.writes[1].text, "1") == 0);
+    CHECK(strcmp(plan.writes[2].text, "10.0.0.2") == 0);
+    CHECK(strcmp(plan.writes[3].text, "10.0.1.1") == 0);
+
+    //once the registry holds it, applying it again writes nothing
+    CHECK(xreg_update_batch(reg, plan.writes, plan.count));
+    CHECK(plan_modified_values(reg, &plan) == APPLY_NOTHING);
+    CHECK(plan.count == 0);
+
+    //only the changed key is left, and a live server still needs the reboot
+    addr_parse("10.0.0.9", 8, &modifiedValues.primaryDns);
+    CHECK(plan_modified_values(reg, &plan) == APPLY_REBOOT);
+    CHECK(plan.count == 1 && strcmp(plan.writes[0].key_name, DNS_PRIMARY_KEY) == 0);
+
+    //servers the console ignores while dns is automatic
+    make_profile(&modifiedValues, "Auto", DNS_FLAG_AUTOMATIC, "10.0.0.2", "10.0.1.1", "", "");
+    CHECK(profile_set_settings(&modifiedValues, "mtu=1400") == SUCCESS);
+    CHECK(plan_modified_values(reg, &plan) == APPLY_REBOOT); //the flag itself changes
+    CHECK(xreg_update_batch(reg, plan.writes, plan.count));
+    make_profile(&modifiedValues, "Auto", DNS_FLAG_AUTOMATIC, "9.9.9.9", "10.0.1.1", "", "");
+    CHECK(profile_set_settings(&modifiedValues, "mtu=1400") == SUCCESS);
+    CHECK(plan_modified_values(reg, &plan) == APPLY_NO_REBOOT);
+    CHECK(plan.count == 1 && strcmp(plan.writes[0].text, "9.9.9.9") == 0);
+
+    //unchanged writes drop out in place, an unknown key fails the whole set
+    xreg_write_t writes[] = {
+        {DNS_FLAG_KEY, "0"},
+        {DNS_SECONDARY_KEY, "10.0.1.1"},
+        {DNS_PRIMARY_KEY, "1.1.1.1"},
+    };
+    CHECK(xreg_filter_unchanged(reg, writes, 3) == 1);
+    CHECK(strcmp(writes[0].key_name, DNS_PRIMARY_KEY) == 0);
+    xreg_write_t unknown[] = {{"/setting/net/nope", "1"}};
+    CHECK(xreg_filter_unchanged(reg, unknown, 1) == -1);
+
+    xreg_free(reg);
+    modifiedValues = currentValues;
+}
+
+//the dns keys come from the profile's own fields, settings can't write them
+//again, and no key may appear twice
+static void test_net_settings_keys(void) {
+    Values profile;
+    make_profile(&profile, "Net", DNS_FLAG_MANUAL, "10.0.0.1", "", "", "");
+    CHECK(profile_set_settings(&profile, "mtu=1400;ipAddressFlag=1") == SUCCESS);
+    CHECK(profile_set_settings(&profile, "mtu=1400;dnsFlag=0") == FAILURE);
+    CHECK(profile_set_settings(&profile, "primaryDns=1.1.1.1") == FAILURE);
+    CHECK(profile_set_settings(&profile, "secondaryDns=1.1.1.1;mtu=1") == FAILURE);
+    CHECK(profile_set_settings(&profile, "mtu=1400;netmask=255.0.0.0;mtu=1500") == FAILURE);
+    CHECK(profile_set_settings(&profile, "mtu=1400;mtuX=1") == SUCCESS); //a prefix isn't the key
+    CHECK(profile_set_settings(&profile, "httpProxyServer=a=b;mtu=1") == SUCCESS);
+    CHECK(net_settings_each("dnsFlagX=1;mtu=2", NULL, NULL) == 2);
+    CHECK(net_settings_each("mtu=1;mtu=1", NULL, NULL) == -1);
+}
+
+//an apply that skips the reboot still writes on the worker, behind the
+//saving dialog, and only then counts as applied
+static void test_apply_without_reboot(void) {
+    mkdir(PLATFORM_ROOT, 0755);
+    mkdir(PLATFORM_ROOT "/dev_flash2", 0755);
+    mkdir(PLATFORM_ROOT "/dev_flash2/etc", 0755);
+    registry = load_test_registry();
+    CHECK(registry != NULL);
+    if (!registry) return;
+
+    make_profile(&modifiedValues, "Bravo", DNS_FLAG_AUTOMATIC, "9.9.9.9", "", "", "");
+    snprintf(applyingName, sizeof(applyingName), "Bravo");
+    begin_apply(registry, 0);
+    CHECK(currentState == STATE_SAVING_DIALOG);
+    tap(INPUT_CIRCLE);
+    CHECK(currentState == STATE_SAVING_DIALOG); //no input until it's written
+    CHECK(savedValueList[3].useCount == 0);
+
+    while (registry_commit_running()) usleep(1000);
+    saving_poll(NULL);
+    CHECK(currentState == STATE_NO_DIALOG);
+    CHECK(strcmp(notice, "Saved. No restart needed.") == 0);
+    CHECK(addr_equal(&currentValues.primaryDns, &modifiedValues.primaryDns));
+    CHECK(savedValueList[3].useCount == 1);
+    CHECK(exit_requested == 0);
+
+    xreg_registry_t *saved = xreg_load(XREG_PATH);
+    char primary[16];
+    CHECK(saved && xreg_get_text(saved, DNS_PRIMARY_KEY, primary, sizeof(primary)) &&
+          strcmp(primary, "9.9.9.9") == 0);
+    if (saved) xreg_free(saved);
+
+    xreg_free(registry);
+    registry = NULL;
+    remove(XREG_PATH);
+}
+
+//a bulk add has to leave every index as sorted as one add per row would
+static int index_sorted(const int *list, int count, int (*cmp)(int, int)) {
+    for(int i = 1; i < count; i++) {
+        if(cmp(list[i - 1], list[i]) >= 0) return 0;
+    }
+    return 1;
+}
+
+static void test_bulk_add(void) {
+    static const char *names[] = {"kilo", "Golf", "zulu", "hotel", "Alpha2", "mike", "Bravo2", "india"};
+    const int count = sizeof(names) / sizeof(names[0]);
+    set_sort_order(SORT_NAME);
+    begin_bulk_add();
+    for(int i = 0; i < count; i++) {
+        Values profile;
+        make_profile(&profile, names[i], DNS_FLAG_MANUAL, "10.0.2.1", "10.0.2.2", i % 2 ? "Odd" : "", "new;new");
+        add_saved_value(&savedValueList, &savedValueCount, profile);
+    }
+    end_bulk_add();
+
+    CHECK(savedValueCount == TEST_ROWS + count);
+    CHECK(index_sorted(nameIndex, savedValueCount, name_cmp));
+    CHECK(sortIndexCount == savedValueCount - 2);
+    CHECK(index_sorted(sortIndex, sortIndexCount, profile_cmp));
+    for(int l = 0; l < labelCount; l++) CHECK(index_sorted(labelIndex[l].rows, labelIndex[l].count, name_cmp));
+    CHECK(get_label("new")->count == count); //a tag listed twice is one row
+    CHECK(get_label("Odd")->count == 3 + count / 2);
+
+    set_search_prefix("b");
+    CHECK(view_count() == 2);
+    CHECK(strcmp(cursor_name(), "Bravo") == 0);
+}
+
+//metric ties, negative latency and the pinned rows all through every order
+static void test_sort_orders(void) {
+    static const int use_counts[] = {3, 0, 3, 7, 0};
+    static const int latencies[] = {-1, 40, 12, -1, 40};
+    for(int i = 0; i < TEST_PROFILES; i++) {
+        savedValueList[i + 2].useCount = use_counts[i];
+        savedValueList[i + 2].lastUsed = use_counts[i] ? 1700000000 + i % 2 : 0;
+        savedValueList[i + 2].latencyMs = latencies[i];
+    }
+    for(int order = 0; order < SORT_ORDER_COUNT; order++) {
+        set_sort_order(order);
+        if(order == SORT_FILE) continue;
+        CHECK(sortIndexCount == TEST_PROFILES);
+        CHECK(index_sorted(sortIndex, sortIndexCount, profile_cmp));
+    }
+    set_sort_order(SORT_USE_COUNT);
+    CHECK(strcmp(savedValueList[view_index(2)].name, "Delta") == 0);
+    CHECK(strcmp(savedValueList[view_index(3)].name, "Alpha") == 0); //ties by name
+    set_sort_order(SORT_LATENCY);
+    CHECK(strcmp(savedValueList[view_index(2)].name, "Charlie") == 0);
+    CHECK(strcmp(savedValueList[view_index(TEST_ROWS - 1)].name, "Delta") == 0); //unmeasured last
+}
+
+static const struct {
+    const char *name;
+    void (*fn)(void);
+} tests[] = {
+    {"cursor wraps",                test_cursor_wraps},
+    {"repeat stops at the ends",    test_repeat_stops_at_the_ends},
+    {"stick scrolls only the table", test_stick_scrolls_only_the_table},
+    {"confirm and cancel",          test_confirm_and_cancel},
+    {"apply failure is recoverable", test_apply_failure_is_recoverable},
+    {"delete",                      test_delete},
+    {"new profile form",            test_new_profile_form},
+    {"search",                      test_search},
+    {"labels",                      test_labels},
+    {"profiler combo",              test_profiler_combo},
+    {"exit",                        test_exit},
+    {"bulk add",                    test_bulk_add},
+    {"sort orders",                 test_sort_orders},
+    {"persist error waits for restart", test_persist_error_waits_for_restart},
+    {"registry plan",               test_registry_plan},
+    {"net settings keys",           test_net_settings_keys},
+    {"apply without reboot",        test_apply_without_reboot},
+};
+
+int main(int argc, char **argv) {
+    remove(TEST_PROFILE_PATH);
+    if (persist_start(TEST_PROFILE_PATH, ',', profile_header, PROFILE_HEADER_COUNT) != 1) {
+        printf("can't start the profile writer\n");
+        return 1;
+    }
+
+    int failed_tests = 0;
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        int before = failures;
+        reset();
+        tests[i].fn();
+        printf("%s %s\n", failures == before ? "ok  " : "FAIL", tests[i].name);
+        if (failures != before) failed_tests++;
+    }
+
+    persist_stop();
+    free_saved_values();
+    remove(TEST_PROFILE_PATH);
+    printf("%d checks, %d failed in %d tests\n", checks, failures, failed_tests);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,406 @@
+//unit tests for the portable modules, no main.c. fopen is wrapped so a test
+//can make one path unreadable while everything else still opens. addr.c is
+//checked against the libc parser as well as its own canonical forms, xreg.c
+//against registries built by fixture_registry.c
+//
+//  make -C host test
+
+#include "persist.h"
+#include "addr.h"
+#include "xreg.h"
+#include "fixture_registry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <arpa/inet.h>
+
+#define TEST_PROFILE_PATH   "modules_test.csv"
+#define TEST_REGISTRY_PATH  "modules_test.sys"
+
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    checks++; \
+    if (!(cond)) { \
+        failures++; \
+        printf("  %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+} while (0)
+
+//fopen for reading fails on this path with EACCES, writing still works
+static const char *unreadable_path = NULL;
+
+FILE *__real_fopen(const char *path, const char *mode);
+
+FILE *__wrap_fopen(const char *path, const char *mode) {
+    if (unreadable_path && mode[0] == 'r' && strcmp(path, unreadable_path) == 0) {
+        errno = EACCES;
+        return NULL;
+    }
+    return __real_fopen(path, mode);
+}
+
+static char *profile_header[] = {"name", "primary", "secondary"};
+#define PROFILE_HEADER_COUNT    3
+
+static const char test_rows[] =
+    "name,primary,secondary\n"
+    "Alpha,10.0.0.1,10.0.1.1\n"
+    "Bravo,10.0.0.2,10.0.1.1\n"
+    "Charlie,10.0.0.3,10.0.1.1\n";
+
+static int write_text(const char *path, const char *text) {
+    FILE *fp = fopen(path, "w");
+    if (!fp) return 0;
+    fputs(text, fp);
+    return fclose(fp) == 0;
+}
+
+//1 if path holds exactly text
+static int file_is(const char *path, const char *text) {
+    char buf[512];
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    size_t len = fread(buf, 1, sizeof(buf), fp);
+    fclose(fp);
+    return len == strlen(text) && memcmp(buf, text, len) == 0;
+}
+
+//persist_stop drains the queue, so the file is final once it returns
+static void run_persister(void (*queue)(void)) {
+    persist_start(TEST_PROFILE_PATH, ',', profile_header, PROFILE_HEADER_COUNT);
+    queue();
+    persist_stop();
+}
+
+static void remove_bravo(void) {
+    persist_remove("Bravo");
+}
+
+static void test_persist_remove(void) {
+    char msg[128];
+    CHECK(write_text(TEST_PROFILE_PATH, test_rows));
+    run_persister(remove_bravo);
+    CHECK(!persist_poll_error(msg, sizeof(msg)));
+    CHECK(file_is(TEST_PROFILE_PATH,
+                  "name,primary,secondary\n"
+                  "Alpha,10.0.0.1,10.0.1.1\n"
+                  "Charlie,10.0.0.3,10.0.1.1\n"));
+}
+
+static void test_persist_remove_missing_file(void) {
+    char msg[128];
+    remove(TEST_PROFILE_PATH);
+    run_persister(remove_bravo);
+    CHECK(!persist_poll_error(msg, sizeof(msg)));
+    CHECK(file_is(TEST_PROFILE_PATH, "name,primary,secondary\n"));
+}
+
+static void test_persist_remove_unreadable_file(void) {
+    char msg[128];
+    CHECK(write_text(TEST_PROFILE_PATH, test_rows));
+    unreadable_path = TEST_PROFILE_PATH;
+    run_persister(remove_bravo);
+    unreadable_path = NULL;
+    CHECK(persist_poll_error(msg, sizeof(msg)));
+    CHECK(strcmp(msg, "Could not read the profile file.") == 0);
+    CHECK(file_is(TEST_PROFILE_PATH, test_rows)); //every row survives
+}
+
+//persist_on_write hook: how often it ran and whether the file was final each time
+static int written_calls = 0;
+static int written_complete = 0;
+static const char *written_expect = NULL;
+
+static void count_write(void *ctx) {
+    written_calls++;
+    written_complete += file_is(TEST_PROFILE_PATH, written_expect);
+}
+
+static void add_delta(void) {
+    char *fields[] = {"Delta", "10.0.0.4", "10.0.1.1"};
+    persist_add(fields, 3);
+}
+
+static void test_persist_write_hook(void) {
+    static const char appended[] =
+        "name,primary,secondary\n"
+        "Alpha,10.0.0.1,10.0.1.1\n"
+        "Bravo,10.0.0.2,10.0.1.1\n"
+        "Charlie,10.0.0.3,10.0.1.1\n"
+        "Delta,10.0.0.4,10.0.1.1\n";
+    persist_on_write(count_write, NULL);
+
+    CHECK(write_text(TEST_PROFILE_PATH, test_rows));
+    written_calls = written_complete = 0;
+    written_expect = appended;
+    run_persister(add_delta); //append
+    CHECK(written_calls == 1 && written_complete == 1);
+
+    written_calls = written_complete = 0;
+    written_expect = "name,primary,secondary\n"
+                     "Alpha,10.0.0.1,10.0.1.1\n"
+                     "Charlie,10.0.0.3,10.0.1.1\n"
+                     "Delta,10.0.0.4,10.0.1.1\n";
+    run_persister(remove_bravo); //rewrite
+    CHECK(written_calls == 1 && written_complete == 1);
+
+    //a batch that writes nothing calls nothing
+    char msg[128];
+    CHECK(write_text(TEST_PROFILE_PATH, test_rows));
+    written_calls = 0;
+    unreadable_path = TEST_PROFILE_PATH;
+    run_persister(remove_bravo);
+    unreadable_path = NULL;
+    CHECK(persist_poll_error(msg, sizeof(msg)));
+    CHECK(written_calls == 0);
+
+    persist_on_write(NULL, NULL);
+}
+
+//text in, family out and the canonical form addr_format gives back. NULL
+//canonical means the text is canonical already
+static const struct {
+    const char *text;
+    int family;
+    const char *canonical;
+} addr_cases[] = {
+    {"1.1.1.1",                 ADDR_V4, NULL},
+    {"255.255.255.255",         ADDR_V4, NULL},
+    {"0.0.0.0",                 ADDR_V4, NULL},
+    {"256.1.1.1",               ADDR_NONE, NULL},
+    {"1.1.1",                   ADDR_NONE, NULL},
+    {"1.1.1.1.1",               ADDR_NONE, NULL},
+    {"1..1.1",                  ADDR_NONE, NULL},
+    {"1.1.1.1.",                ADDR_NONE, NULL},
+    {"01.1.1.1",                ADDR_NONE, NULL},   //leading zero, inet_pton says no too
+    {"1.1.1.0001",              ADDR_NONE, NULL},
+    {" 1.1.1.1",                ADDR_NONE, NULL},
+
+    {"::",                      ADDR_V6, NULL},
+    {"::1",                     ADDR_V6, NULL},
+    {"1::",                     ADDR_V6, NULL},
+    {"2001:db8::8:800:200c:417a", ADDR_V6, NULL},
+    {"2001:DB8:0:0:8:800:200C:417A", ADDR_V6, "2001:db8::8:800:200c:417a"},
+    {"0:0:0:0:0:0:0:0",         ADDR_V6, "::"},
+    {"0000:0000:0000:0000:0000:0000:0000:0001", ADDR_V6, "::1"},
+    {"2001:0db8:0000:0000:0000:0000:0002:0001", ADDR_V6, "2001:db8::2:1"},
+    {"1:0:2:3:4:5:6:7",         ADDR_V6, NULL},     //a single zero stays
+    {"1:0:0:2:0:0:0:3",         ADDR_V6, "1:0:0:2::3"},     //longest run
+    {"1:0:0:2:0:0:3:4",         ADDR_V6, "1::2:0:0:3:4"},   //first of a tie
+    {"1:2:3:4:5:6:7::",         ADDR_V6, "1:2:3:4:5:6:7:0"},
+    {"::2:3:4:5:6:7:8",         ADDR_V6, "0:2:3:4:5:6:7:8"},
+    {"::ffff:1.2.3.4",          ADDR_V6, NULL},
+    {"::FFFF:0102:0304",        ADDR_V6, "::ffff:1.2.3.4"},
+    {"64:ff9b::192.0.2.33",     ADDR_V6, "64:ff9b::c000:221"},
+    {"1:2:3:4:5:6:1.2.3.4",     ADDR_V6, "1:2:3:4:5:6:102:304"},
+    {"::1.2.3.4",               ADDR_V6, "::102:304"},
+    {"0000:0000:0000:0000:0000:ffff:255.255.255.255", ADDR_V6, "::ffff:255.255.255.255"},
+
+    {":",                       ADDR_NONE, NULL},
+    {":::",                     ADDR_NONE, NULL},
+    {"1:::2",                   ADDR_NONE, NULL},
+    {"1::2::3",                 ADDR_NONE, NULL},
+    {":1::",                    ADDR_NONE, NULL},
+    {"1::2:",                   ADDR_NONE, NULL},
+    {"1:2:3:4:5:6:7",           ADDR_NONE, NULL},   //seven groups, no "::"
+    {"1:2:3:4:5:6:7:8:9",       ADDR_NONE, NULL},
+    {"1:2:3:4:5:6:7:8::",       ADDR_NONE, NULL},   //"::" standing for nothing
+    {"::1:2:3:4:5:6:7:8",       ADDR_NONE, NULL},
+    {"12345::",                 ADDR_NONE, NULL},   //overlong group
+    {"::00001",                 ADDR_NONE, NULL},
+    {"1:2:3:4:5:6:7:1.2.3.4",   ADDR_NONE, NULL},   //the quad needs two groups
+    {"1:2:3:4:5:6::1.2.3.4",    ADDR_NONE, NULL},
+    {"::1.2.3",                 ADDR_NONE, NULL},
+    {"::01.2.3.4",              ADDR_NONE, NULL},
+    {"::1.2.3.4:5",             ADDR_NONE, NULL},
+    {"1.2.3.4::",               ADDR_NONE, NULL},
+    {"::g",                     ADDR_NONE, NULL},
+    {"",                        ADDR_NONE, NULL},
+    {"0000:0000:0000:0000:0000:0000:0000:0000:0", ADDR_NONE, NULL},
+};
+#define ADDR_CASE_COUNT (sizeof(addr_cases) / sizeof(addr_cases[0]))
+
+static void test_addr_cases(void) {
+    for (size_t i = 0; i < ADDR_CASE_COUNT; i++) {
+        const char *text = addr_cases[i].text;
+        addr_t addr;
+        int family = addr_parse(text, strlen(text), &addr);
+        if (family != addr_cases[i].family) {
+            printf("  %s: family %d, expected %d\n", text, family, addr_cases[i].family);
+        }
+        CHECK(family == addr_cases[i].family);
+        if (family == ADDR_NONE) continue;
+
+        char out[ADDR_STRLEN];
+        const char *canonical = addr_cases[i].canonical ? addr_cases[i].canonical : text;
+        size_t len = addr_format(&addr, out, sizeof(out));
+        if (strcmp(out, canonical) != 0) printf("  %s: formats as %s\n", text, out);
+        CHECK(strcmp(out, canonical) == 0);
+        CHECK(len == strlen(canonical));
+
+        //the canonical form parses back to the same bytes
+        addr_t again;
+        CHECK(addr_parse(out, len, &again) == family);
+        CHECK(addr_equal(&addr, &again));
+    }
+}
+
+//every case is accepted or refused exactly as inet_pton does, with its bytes
+static void test_addr_matches_inet_pton(void) {
+    for (size_t i = 0; i < ADDR_CASE_COUNT; i++) {
+        const char *text = addr_cases[i].text;
+        addr_t addr;
+        int family = addr_parse(text, strlen(text), &addr);
+        uint8_t v4[4], v6[16];
+        int libc_family = inet_pton(AF_INET, text, v4) == 1 ? ADDR_V4 :
+                          inet_pton(AF_INET6, text, v6) == 1 ? ADDR_V6 : ADDR_NONE;
+        if (family != libc_family) printf("  %s: %d, inet_pton %d\n", text, family, libc_family);
+        CHECK(family == libc_family);
+        if (family == ADDR_V4 && libc_family == ADDR_V4) CHECK(memcmp(addr.bytes, v4, 4) == 0);
+        if (family == ADDR_V6 && libc_family == ADDR_V6) CHECK(memcmp(addr.bytes, v6, 16) == 0);
+    }
+}
+
+//random addresses heavy on zero runs format like inet_ntop and parse back.
+//glibc keeps a dotted tail on the deprecated ::a.b.c.d form, rfc 5952 doesn't
+static void test_addr_round_trip(void) {
+    uint32_t seed = 12345;
+    int mismatches = 0;
+    for (int i = 0; i < 20000; i++) {
+        addr_t addr = {ADDR_V6};
+        for (int w = 0; w < 8; w++) {
+            seed = seed * 1103515245u + 12345u;
+            unsigned v = (seed >> 16) & 3 ? 0 : (seed >> 8) & 0xFFFF;
+            if (((seed >> 4) & 7) == 0) v = 0xFFFF;
+            addr.bytes[2 * w] = (uint8_t)(v >> 8);
+            addr.bytes[2 * w + 1] = (uint8_t)v;
+        }
+        static const uint8_t zero12[12] = {0};
+        int compat = memcmp(addr.bytes, zero12, 12) == 0 && (addr.bytes[12] | addr.bytes[13]);
+
+        char ours[ADDR_STRLEN], libc[INET6_ADDRSTRLEN];
+        size_t len = addr_format(&addr, ours, sizeof(ours));
+        inet_ntop(AF_INET6, addr.bytes, libc, sizeof(libc));
+        if (!compat && strcmp(ours, libc) != 0 && mismatches++ < 5) printf("  %s, inet_ntop %s\n", ours, libc);
+
+        addr_t again;
+        if (addr_parse(ours, len, &again) != ADDR_V6 || !addr_equal(&addr, &again)) mismatches++;
+    }
+    CHECK(mismatches == 0);
+
+    for (unsigned v = 0; v < 256; v += 51) { //and the v4 side
+        addr_t addr = {ADDR_V4, {(uint8_t)v, 0, (uint8_t)(255 - v), 10}};
+        char ours[ADDR_STRLEN], libc[INET_ADDRSTRLEN];
+        addr_format(&addr, ours, sizeof(ours));
+        inet_ntop(AF_INET, addr.bytes, libc, sizeof(libc));
+        CHECK(strcmp(ours, libc) == 0);
+    }
+}
+
+//the length is the whole input: no terminator needed, nothing past len read
+static void test_addr_exact_length(void) {
+    addr_t addr;
+    CHECK(addr_parse("1.1.1.1junk", 7, &addr) == ADDR_V4);
+    CHECK(addr_parse("::1junk", 3, &addr) == ADDR_V6);
+    CHECK(addr_parse("1.1.1.1", 6, &addr) == ADDR_NONE);
+
+    char out[8];
+    addr_parse("::ffff:1.2.3.4", 14, &addr);
+    CHECK(addr_format(&addr, out, sizeof(out)) == 7); //truncated, terminated
+    CHECK(strcmp(out, "::ffff:") == 0);
+
+    addr_t none = {0};
+    CHECK(addr_format(&none, out, sizeof(out)) == 0 && out[0] == '\0');
+}
+
+//numbers are refused outside what their width holds instead of wrapping,
+//and a refused value leaves the whole batch unwritten
+static void test_xreg_number_ranges(void) {
+    static const fixture_key_t keys[] = {
+        {"/test/bool",  0, 1, NULL, 1},
+        {"/test/short", 1, 2, NULL, 80},
+        {"/test/int",   1, 4, NULL, 1500},
+        {"/test/text",  2, 8, "abc", 0},
+    };
+    CHECK(write_registry_keys(TEST_REGISTRY_PATH, keys, 4));
+    xreg_registry_t *reg = xreg_load(TEST_REGISTRY_PATH);
+    remove(TEST_REGISTRY_PATH);
+    CHECK(reg != NULL);
+    if (!reg) return;
+
+    static const struct {
+        const char *key;
+        const char *text;
+        int ok;
+    } writes[] = {
+        {"/test/bool",  "0",            1},
+        {"/test/bool",  "255",          1},
+        {"/test/bool",  "256",          0},
+        {"/test/bool",  "300",          0},
+        {"/test/bool",  "-1",           0},
+        {"/test/short", "65535",        1},
+        {"/test/short", "65536",        0},
+        {"/test/short", "-1",           0},
+        {"/test/int",   "-2147483648",  1},
+        {"/test/int",   "2147483647",   1},
+        {"/test/int",   "2147483648",   0},
+        {"/test/int",   "99999999999999999999", 0},
+        {"/test/int",   "",             0},
+        {"/test/int",   "12a",          0},
+        {"/test/text",  "abcdefgh",     1},
+        {"/test/text",  "abcdefghi",    0},
+    };
+    for (size_t i = 0; i < sizeof(writes) / sizeof(writes[0]); i++) {
+        xreg_write_t write = {writes[i].key, writes[i].text};
+        int ok = xreg_filter_unchanged(reg, &write, 1) >= 0;
+        if (ok != writes[i].ok) printf("  %s=%s: %s\n", writes[i].key, writes[i].text, ok ? "taken" : "refused");
+        CHECK(ok == writes[i].ok);
+    }
+
+    //what's written reads back as the same text
+    char out[16];
+    xreg_write_t batch[] = {{"/test/bool", "0"}, {"/test/short", "65535"}, {"/test/int", "-5"}};
+    CHECK(xreg_update_batch(reg, batch, 3));
+    CHECK(xreg_get_text(reg, "/test/short", out, sizeof(out)) && strcmp(out, "65535") == 0);
+    CHECK(xreg_get_text(reg, "/test/int", out, sizeof(out)) && strcmp(out, "-5") == 0);
+
+    xreg_write_t bad[] = {{"/test/short", "1"}, {"/test/bool", "300"}};
+    CHECK(!xreg_update_batch(reg, bad, 2));
+    CHECK(xreg_get_text(reg, "/test/short", out, sizeof(out)) && strcmp(out, "65535") == 0);
+    CHECK(xreg_get_text(reg, "/test/bool", out, sizeof(out)) && strcmp(out, "0") == 0);
+
+    xreg_free(reg);
+}
+
+static const struct {
+    const char *name;
+    void (*fn)(void);
+} tests[] = {
+    {"persist remove",                  test_persist_remove},
+    {"persist remove, missing file",    test_persist_remove_missing_file},
+    {"persist remove, unreadable file", test_persist_remove_unreadable_file},
+    {"persist write hook",              test_persist_write_hook},
+    {"xreg number ranges",              test_xreg_number_ranges},
+    {"addr parse and format",           test_addr_cases},
+    {"addr matches inet_pton",          test_addr_matches_inet_pton},
+    {"addr round trip",                 test_addr_round_trip},
+    {"addr exact length",               test_addr_exact_length},
+};
+
+int main(int argc, char **argv) {
+    int failed_tests = 0;
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        int before = failures;
+        tests[i].fn();
+        printf("%s %s\n", failures == before ? "ok  " : "FAIL", tests[i].name);
+        if (failures != before) failed_tests++;
+    }
+
+    remove(TEST_PROFILE_PATH);
+    printf("%d checks, %d failed in %d tests\n", checks, failures, failed_tests);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,579 @@
+//host side of platform.h: replays a pad script against main.c with no
+//window. every draw call goes to a text trace, every frame's cpu time to
+//the report, so a slow change shows up as numbers on a linux box.
+//
+//  ezdns-replay [-t trace.txt] [-q] [-v] [-l] script.pad
+//
+//-l fails the run when heap blocks are still live at exit (alloc_count.c)
+//
+//script lines are "<frame> <command> [arg]", frames count main loop
+//iterations from 0, '#' starts a comment:
+//  12 press cross          held until released
+//  14 release cross        a press and release on one frame cancel out
+//  20 tap down             press now, release next frame
+//  30 stick 255            left stick vertical, 0 up .. 128 rest .. 255 down
+//  40 osk 1.1.1.1          finish the open keyboard with this text
+//  41 osk-cancel
+//  90 end                  stop here instead of SETTLE_FRAMES after the last line
+//  0 budget 16666          from here on a drawn frame over this many us of cpu
+//                          fails the run, 0 turns the check off
+//
+//a soft reboot ends the replay on the frame it happens, like the console
+
+#include "platform.h"
+#include "osk.h"
+#include "debug.h"
+#include "profiler.h"
+#include "fixture_registry.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+uint64_t alloc_count(void);         //alloc_count.c
+int64_t alloc_live_count(void);
+
+#define FRAME_US            16667   //virtual clock step, one 60hz frame
+#define SETTLE_FRAMES       60      //run this long past the last event
+#define SCREEN_W            848.0f
+#define GLYPH_W             8.0f    //platform_font_init's 8x13
+#define SCRIPT_LINE_SIZE    256
+#define OSK_TEXT_SIZE       128
+#define DRAIN_POLL_US       500     //background threads get this long between checks
+#define DRAIN_LIMIT_US      10000000
+
+typedef enum {
+    EV_PRESS,
+    EV_RELEASE,
+    EV_STICK,
+    EV_OSK,
+    EV_OSK_CANCEL,
+    EV_BUDGET,
+    EV_END
+} ReplayEventType;
+
+typedef struct {
+    unsigned int frame;
+    ReplayEventType type;
+    uint32_t button;        //INPUT_BIT
+    int value;              //stick, budget
+    char text[OSK_TEXT_SIZE];
+} ReplayEvent;
+
+typedef struct {
+    unsigned int frame;
+    int drawn;
+    uint32_t cpu_us;
+    uint32_t quads;
+    uint32_t texts;
+} FrameRecord;
+
+static const char *button_names[INPUT_BUTTON_COUNT] = {
+    [INPUT_SELECT]   = "select",
+    [INPUT_CROSS]    = "cross",
+    [INPUT_CIRCLE]   = "circle",
+    [INPUT_SQUARE]   = "square",
+    [INPUT_TRIANGLE] = "triangle",
+    [INPUT_START]    = "start",
+    [INPUT_UP]       = "up",
+    [INPUT_DOWN]     = "down",
+    [INPUT_LEFT]     = "left",
+    [INPUT_RIGHT]    = "right",
+    [INPUT_L1]       = "l1",
+    [INPUT_R1]       = "r1",
+    [INPUT_L2]       = "l2",
+    [INPUT_R2]       = "r2",
+    [INPUT_L3]       = "l3",
+    [INPUT_R3]       = "r3",
+};
+
+static ReplayEvent *events = NULL;
+static size_t event_count = 0;
+static size_t event_pos = 0;
+static unsigned int last_frame = 0;    //stop after this one
+
+static FrameRecord *records = NULL;
+static size_t record_count = 0;
+static size_t record_capacity = 0;
+
+static FILE *trace = NULL;
+static int quiet = 0;
+static int verbose = 0;
+static int leak_check = 0;
+
+static int (*background_busy)(void) = NULL;
+static uint64_t clock_us = 0;       //virtual once started, so key repeat replays the same every run
+static int started = 0;             //first main loop iteration seen
+static int rebooted = 0;            //the console would be gone, end the replay
+static unsigned int frame = 0;
+static unsigned int startup_frames = 0;
+static uint32_t frame_budget_us = 0;    //0 = no budget
+static unsigned int over_budget = 0;
+static uint64_t frame_cpu_start = 0;
+static uint32_t frame_quads = 0;
+static uint32_t frame_texts = 0;
+
+static uint32_t pad_buttons = 0;
+static uint16_t pad_stick = 0x80;
+
+static uint32_t text_color = 0xFFFFFFFF;
+static int text_center = 0;
+
+static char *osk_dest = NULL;
+static int osk_dest_size = 0;
+static int osk_state = OSK_EDIT_NONE;
+
+static uint64_t clock_read_us(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t thread_cpu_us(void) {
+    return clock_read_us(CLOCK_THREAD_CPUTIME_ID);
+}
+
+//draws while loading race the loader thread, they get no frame number so
+//traces of two runs diff clean
+static const char *frame_label(void) {
+    static char label[16];
+    if (!started) return "load";
+    snprintf(label, sizeof(label), "%u", frame);
+    return label;
+}
+
+static void fail(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "ezdns-replay: ");
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    exit(1);
+}
+
+static int parse_button(const char *name, uint32_t *bit) {
+    for (int b = 0; b < INPUT_BUTTON_COUNT; b++) {
+        if (strcmp(name, button_names[b]) == 0) {
+            *bit = INPUT_BIT(b);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//kept in frame order, a tap's release can land after later lines
+static void add_event(const ReplayEvent *ev) {
+    ReplayEvent *tmp = realloc(events, (event_count + 1) * sizeof(ReplayEvent));
+    if (!tmp) fail("out of memory");
+    events = tmp;
+
+    size_t at = event_count;
+    while (at > 0 && events[at - 1].frame > ev->frame) at--;
+    memmove(&events[at + 1], &events[at], (event_count - at) * sizeof(ReplayEvent));
+    events[at] = *ev;
+    event_count++;
+}
+
+static void load_script(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) fail("can't open %s: %s", path, strerror(errno));
+
+    char line[SCRIPT_LINE_SIZE];
+    int line_no = 0;
+    unsigned int prev_frame = 0;
+    int ended = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        line[strcspn(line, "\r\n")] = '\0';
+
+        unsigned int at;
+        char cmd[32];
+        int used = 0;
+        if (sscanf(line, " %u %31s %n", &at, cmd, &used) < 2) {
+            if (strspn(line, " \t") == strlen(line)) continue; //blank
+            fail("%s:%d: expected \"<frame> <command>\"", path, line_no);
+        }
+        if (at < prev_frame) fail("%s:%d: frames must not go backwards", path, line_no);
+        if (ended) fail("%s:%d: events after end", path, line_no);
+        prev_frame = at;
+
+        const char *arg = line + used;
+        ReplayEvent ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.frame = at;
+        if (strcmp(cmd, "press") == 0 || strcmp(cmd, "release") == 0 || strcmp(cmd, "tap") == 0) {
+            char name[16];
+            if (sscanf(arg, "%15s", name) != 1 || !parse_button(name, &ev.button)) {
+                fail("%s:%d: unknown button \"%s\"", path, line_no, arg);
+            }
+            ev.type = cmd[0] == 'r' ? EV_RELEASE : EV_PRESS;
+            add_event(&ev);
+            if (cmd[0] == 't') {
+                ev.type = EV_RELEASE;
+                ev.frame = at + 1;
+                add_event(&ev);
+            }
+        } else if (strcmp(cmd, "stick") == 0) {
+            if (sscanf(arg, "%d", &ev.value) != 1 || ev.value < 0 || ev.value > 255) {
+                fail("%s:%d: stick wants 0..255", path, line_no);
+            }
+            ev.type = EV_STICK;
+            add_event(&ev);
+        } else if (strcmp(cmd, "osk") == 0) {
+            ev.type = EV_OSK;
+            snprintf(ev.text, sizeof(ev.text), "%s", arg);
+            add_event(&ev);
+        } else if (strcmp(cmd, "osk-cancel") == 0) {
+            ev.type = EV_OSK_CANCEL;
+            add_event(&ev);
+        } else if (strcmp(cmd, "budget") == 0) {
+            if (sscanf(arg, "%d", &ev.value) != 1 || ev.value < 0) {
+                fail("%s:%d: budget wants microseconds", path, line_no);
+            }
+            ev.type = EV_BUDGET;
+            add_event(&ev);
+        } else if (strcmp(cmd, "end") == 0) {
+            ev.type = EV_END;
+            add_event(&ev);
+            ended = 1;
+        } else {
+            fail("%s:%d: unknown command \"%s\"", path, line_no, cmd);
+        }
+    }
+    fclose(f);
+
+    if (event_count == 0) fail("%s: no events", path);
+    last_frame = events[event_count - 1].frame + SETTLE_FRAMES;
+    for (size_t i = 0; i < event_count; i++) {
+        if (events[i].type == EV_END) last_frame = events[i].frame;
+    }
+}
+
+static void make_dir(const char *path) {
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%s", path);
+    for (char *p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        mkdir(buf, 0755);
+        *p = '/';
+    }
+    if (mkdir(buf, 0755) != 0 && errno != EEXIST) fail("can't create %s: %s", buf, strerror(errno));
+}
+
+void platform_init(int argc, char **argv) {
+    const char *trace_path = NULL;
+    const char *script_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) trace_path = argv[++i];
+        else if (strcmp(argv[i], "-q") == 0) quiet = 1;
+        else if (strcmp(argv[i], "-v") == 0) verbose = 1;
+        else if (strcmp(argv[i], "-l") == 0) leak_check = 1;
+        else if (argv[i][0] != '-' && !script_path) script_path = argv[i];
+        else script_path = NULL, i = argc; //usage below
+    }
+    if (!script_path) {
+        fprintf(stderr, "usage: %s [-t trace.txt] [-q] [-v] [-l] script.pad\n", argc ? argv[0] : "ezdns-replay");
+        exit(2);
+    }
+    load_script(script_path);
+
+    if (trace_path) {
+        trace = fopen(trace_path, "w");
+        if (!trace) fail("can't open %s: %s", trace_path, strerror(errno));
+    }
+
+    make_dir(PLATFORM_ROOT "/dev_flash2/etc");
+    make_dir(PLATFORM_ROOT "/dev_hdd0/tmp");
+    make_dir(PLATFORM_ROOT "/dev_usb000");
+    struct stat st;
+    if (stat(PLATFORM_ROOT "/dev_flash2/etc/xRegistry.sys", &st) != 0) {
+        if (!write_fixture_registry(PLATFORM_ROOT "/dev_flash2/etc/xRegistry.sys")) {
+            fail("can't write " PLATFORM_ROOT "/dev_flash2/etc/xRegistry.sys");
+        }
+    }
+}
+
+int platform_running(void) {
+    return !rebooted && (!started || frame <= last_frame);
+}
+
+//wall time while loading so the startup marks mean something, then a
+//frame per main loop iteration
+uint64_t platform_time_us(void) {
+    return started ? clock_us : clock_read_us(CLOCK_MONOTONIC);
+}
+
+//a frame doesn't end until the app's threads are done with what it
+//started, so a persister burst or a registry commit always lands on the
+//same frame however long the disk takes
+static void drain_background(void) {
+    uint64_t waited = 0;
+    while (background_busy && background_busy()) {
+        if (waited >= DRAIN_LIMIT_US) fail("frame %u: background work still busy after %d s", frame, DRAIN_LIMIT_US / 1000000);
+        usleep(DRAIN_POLL_US);
+        waited += DRAIN_POLL_US;
+    }
+}
+
+static void record_frame(int drawn) {
+    if (!started) {
+        startup_frames++;
+        usleep(1000); //the loading screen would wait for vblank, don't spin against the loader
+        return;
+    }
+    uint32_t cpu_us = (uint32_t)(thread_cpu_us() - frame_cpu_start);
+    drain_background();
+    clock_us += FRAME_US;
+
+    if (record_count == record_capacity) {
+        record_capacity = record_capacity ? record_capacity * 2 : 256;
+        FrameRecord *tmp = realloc(records, record_capacity * sizeof(FrameRecord));
+        if (!tmp) fail("out of memory");
+        records = tmp;
+    }
+    FrameRecord *r = &records[record_count++];
+    r->frame = frame;
+    r->drawn = drawn;
+    r->cpu_us = cpu_us;
+    r->quads = frame_quads;
+    r->texts = frame_texts;
+    if (!quiet) {
+        printf("frame %5u %-5s %6u us %4u quads %4u texts\n", r->frame,
+               drawn ? "drawn" : "idle", r->cpu_us, r->quads, r->texts);
+    }
+    if (drawn && frame_budget_us && cpu_us > frame_budget_us) {
+        fflush(stdout); //keep it next to the frame's line
+        fprintf(stderr, "ezdns-replay: frame %u took %u us, budget %u us\n", frame, cpu_us, frame_budget_us);
+        over_budget++;
+    }
+    frame++;
+}
+
+void platform_idle(uint32_t us) {
+    (void)us; //no point waiting, the virtual clock moves a frame
+    record_frame(0);
+}
+
+void platform_set_background(int (*busy)(void)) {
+    background_busy = busy;
+}
+
+void platform_gfx_init(void) {
+}
+
+void platform_font_init(void) {
+    text_color = 0xFFFFFFFF;
+    text_center = 0;
+}
+
+void platform_clear(uint32_t color) {
+    frame_quads = frame_texts = 0;
+    if (trace) fprintf(trace, "%s clear %08x\n", frame_label(), color);
+}
+
+void platform_flip(void) {
+    if (trace) fprintf(trace, "%s flip\n", frame_label());
+    record_frame(1);
+}
+
+void platform_quad(float x, float y, float w, float h, uint32_t color, float z) {
+    frame_quads++;
+    prof_draw(4);
+    if (trace) fprintf(trace, "%s quad %.1f %.1f %.1f %.1f %08x %.0f\n", frame_label(), x, y, w, h, color, z);
+}
+
+float platform_text(float x, float y, const char *str) {
+    float w = GLYPH_W * strlen(str);
+    if (text_center) x = (SCREEN_W - w) / 2;
+    frame_texts++;
+    if (trace) fprintf(trace, "%s text %.1f %.1f %08x \"%s\"\n", frame_label(), x, y, text_color, str);
+    return x + w;
+}
+
+float platform_textf(float x, float y, const char *fmt, ...) {
+    char buf[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return platform_text(x, y, buf);
+}
+
+void platform_text_color(uint32_t color, uint32_t bkcolor) {
+    (void)bkcolor;
+    text_color = color;
+}
+
+void platform_text_center(int on) {
+    text_center = on;
+}
+
+void platform_pad_init(void) {
+}
+
+void platform_pad_end(void) {
+}
+
+//one pad on port 0
+int platform_pad_read(int port, platform_pad_t *pad) {
+    if (port != 0) return PLATFORM_PAD_NONE;
+    pad->buttons = pad_buttons;
+    pad->stick_v = pad_stick;
+    return PLATFORM_PAD_NEW;
+}
+
+void platform_net_init(void) {
+}
+
+//first call of every main loop iteration: start the frame and apply its events
+void platform_poll_system(void) {
+    if (!started) clock_us = clock_read_us(CLOCK_MONOTONIC);
+    started = 1;
+    frame_cpu_start = thread_cpu_us();
+    frame_quads = frame_texts = 0;
+
+    for (; event_pos < event_count && events[event_pos].frame <= frame; event_pos++) {
+        const ReplayEvent *ev = &events[event_pos];
+        switch (ev->type) {
+        case EV_PRESS:
+            pad_buttons |= ev->button;
+            break;
+        case EV_RELEASE:
+            pad_buttons &= ~ev->button;
+            break;
+        case EV_STICK:
+            pad_stick = (uint16_t)ev->value;
+            break;
+        case EV_OSK:
+        case EV_OSK_CANCEL:
+            if (osk_state != OSK_EDIT_PENDING) {
+                fprintf(stderr, "ezdns-replay: frame %u: no keyboard open\n", frame);
+                break;
+            }
+            if (ev->type == EV_OSK) snprintf(osk_dest, osk_dest_size, "%s", ev->text);
+            osk_state = ev->type == EV_OSK ? OSK_EDIT_DONE : OSK_EDIT_CANCELED;
+            if (trace) fprintf(trace, "%s osk %s\n", frame_label(), ev->type == EV_OSK ? ev->text : "(canceled)");
+            break;
+        case EV_BUDGET:
+            frame_budget_us = (uint32_t)ev->value;
+            break;
+        case EV_END:
+            break;
+        }
+    }
+}
+
+int platform_overlay_open(void) {
+    return 0; //no system menu to keep alive
+}
+
+void platform_ring_buzzer(int beeps) {
+    if (trace) fprintf(trace, "%s buzzer %d\n", frame_label(), beeps);
+}
+
+int platform_soft_reboot(void) {
+    if (trace) fprintf(trace, "%s reboot\n", frame_label());
+    rebooted = 1;
+    return 0;
+}
+
+static int cmp_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+void platform_exit(void) {
+    uint32_t *drawn = malloc((record_count + 1) * sizeof(uint32_t));
+    size_t drawn_count = 0;
+    uint64_t total = 0, drawn_total = 0;
+    for (size_t i = 0; i < record_count; i++) {
+        total += records[i].cpu_us;
+        if (!records[i].drawn) continue;
+        drawn_total += records[i].cpu_us;
+        if (drawn) drawn[drawn_count++] = records[i].cpu_us;
+    }
+
+    printf("frames %zu (%zu drawn, %zu idle), %u startup frames\n",
+           record_count, drawn_count, record_count - drawn_count, startup_frames);
+    printf("cpu total %llu us, %.1f us/frame\n", (unsigned long long)total,
+           record_count ? (double)total / record_count : 0.0);
+    if (drawn && drawn_count) {
+        qsort(drawn, drawn_count, sizeof(uint32_t), cmp_u32);
+        size_t p99 = drawn_count * 99 / 100;
+        if (p99 >= drawn_count) p99 = drawn_count - 1;
+        printf("drawn frames: mean %.1f us, p50 %u us, p99 %u us, max %u us\n",
+               (double)drawn_total / drawn_count, drawn[drawn_count / 2], drawn[p99], drawn[drawn_count - 1]);
+    }
+    free(drawn);
+
+    free(records);
+    free(events);
+    records = NULL;
+    events = NULL;
+    record_count = record_capacity = event_count = 0;
+
+    int64_t live = alloc_live_count();
+    printf("heap %llu allocations, %lld blocks live at exit\n",
+           (unsigned long long)alloc_count(), (long long)live);
+
+    if (trace) fclose(trace);
+    trace = NULL;
+    if (leak_check && live != 0) {
+        fprintf(stderr, "ezdns-replay: %lld heap blocks leaked\n", (long long)live);
+        exit(1);
+    }
+    if (over_budget) {
+        fprintf(stderr, "ezdns-replay: %u frames over budget\n", over_budget);
+        exit(1);
+    }
+}
+
+//the keyboard: osk_begin opens it, a script "osk" line closes it
+int osk_session_open(void) {
+    return 1;
+}
+
+void osk_session_close(void) {
+}
+
+int osk_begin(const char *caption, char *str, int len) {
+    if (osk_state != OSK_EDIT_NONE) return 0; //one edit at a time
+    osk_dest = str;
+    osk_dest_size = len;
+    osk_state = OSK_EDIT_PENDING;
+    if (trace) fprintf(trace, "%s osk-open \"%s\"\n", frame_label(), caption);
+    return 1;
+}
+
+int osk_poll(void) {
+    int state = osk_state;
+    if (state == OSK_EDIT_DONE || state == OSK_EDIT_CANCELED) osk_state = OSK_EDIT_NONE;
+    return state;
+}
+
+int osk_active(void) {
+    return osk_state != OSK_EDIT_NONE; //until osk_poll has handed over the result
+}
+
+void netDebugInit() {
+}
+
+void netDebug(const char* fmt, ...) {
+    if (!verbose) return;
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "debug: ");
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
@@ -0,0 +1,43 @@
+#ifndef ADDR_H
+#define ADDR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ADDR_NONE   0
+#define ADDR_V4     4
+#define ADDR_V6     6
+
+// binary address, network byte order. family ADDR_NONE means unset/<auto>
+typedef struct {
+    uint8_t family;
+    uint8_t bytes[16];  // v4 uses the first 4
+} addr_t;
+
+// parse exactly len bytes of s. returns the family parsed, or ADDR_NONE on failure
+int addr_parse_v4(const char *s, size_t len, uint8_t out[4]);
+int addr_parse_v6(const char *s, size_t len, uint8_t out[16]);
+int addr_parse(const char *s, size_t len, addr_t *out);
+
+// parse count nul-terminated strings into out[0..count). invalid entries come
+// back as ADDR_NONE. returns how many parsed, so == count means all valid
+size_t addr_parse_many(const char *const *strs, size_t count, addr_t *out);
+
+// longest text form incl. terminator (same as INET6_ADDRSTRLEN)
+#define ADDR_STRLEN 46
+#define ADDR_MIN_STRLEN 2   // "::"
+
+// canonical text form (rfc 5952 for v6). ADDR_NONE formats as "". returns length
+size_t addr_format(const addr_t *addr, char *out, size_t out_size);
+
+int addr_equal(const addr_t *a, const addr_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ADDR_H
@@ -4,93 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-
-#define FIELDS_CAPACITY 3  //max number of fields
-#define ROW_CAPACITY    20 //max number of rows
-
-typedef struct {
-    char **fields;
-    size_t count;
-} CSVRow;
-
-typedef struct {
-    CSVRow *rows;
-    size_t count;
-} CSVTable;
-
-static inline char *csv_strdup(const char *s, size_t len) {
-    char *out = malloc(len + 1);
-    memcpy(out, s, len);
-    out[len] = '\0';
-    return out;
-}
-
-static inline ssize_t getline(char **lineptr, size_t *n, FILE *stream) {
-    if (!lineptr || !n || !stream) return -1;
-    int c;
-    size_t i = 0;
-
-    if (*lineptr == NULL || *n == 0) {
-        *n = 128;
-        *lineptr = malloc(*n);
-        if (!*lineptr) return -1;
-    }
-
-    while ((c = fgetc(stream)) != EOF) {
-        if (i + 1 >= *n) {
-            *n *= 2;
-            *lineptr = realloc(*lineptr, *n);
-            if (!*lineptr) return -1;
-        }
-        (*lineptr)[i++] = c;
-        if (c == '\n') break;
-    }
-
-    if (i == 0) return -1; // EOF
-    (*lineptr)[i] = '\0';
-    return i;
-}
-
-static inline CSVRow csv_parse_line(const char *line, char delimiter) {
-    CSVRow row = {NULL, 0};
-    size_t capacity = FIELDS_CAPACITY;
-    row.fields = malloc(capacity * sizeof(char *));
-
-    const char *p = line;
-    while (*p) {
-        if (row.count >= capacity) {
-            capacity *= 2;
-            row.fields = realloc(row.fields, capacity * sizeof(char *));
-        }
-
-        char *field;
-        if (*p == '"') {
-            p++;
-            const char *start = p;
-            while (*p && !(*p == '"' && (*(p + 1) == delimiter || *(p + 1) == '\0'))) {
-                if (*p == '"' && *(p + 1) == '"') p++; // skip escaped quote
-                p++;
-            }
-            field = csv_strdup(start, p - start);
-            if (*p == '"') p++;
-        } else {
-            const char *start = p;
-            while (*p && *p != delimiter) p++;
-            field = csv_strdup(start, p - start);
-        }
-
-        row.fields[row.count++] = field;
-        if (*p == delimiter) p++;
-    }
-
-    return row;
-}
-
-/* Free a single row */
-static inline void csv_free_row(CSVRow *row) {
-    for (size_t i = 0; i < row->count; i++) free(row->fields[i]);
-    free(row->fields);
-}
+#include <stdint.h>
 
 static inline int csv_create(const char *filename, char **header, size_t count, char delimiter) {
     FILE *fp = fopen(filename, "r");
@@ -119,7 +33,7 @@ static inline int csv_append_row(const char *filename, char **fields, size_t cou
     if (!fp) return 0;
     for (size_t i = 0; i < count; i++) {
         const char *field = fields[i];
-        int needs_quotes = strchr(field, delimiter) || strchr(field, '"') || strchr(field, '\n');
+        int needs_quotes = strchr(field, delimiter) || strchr(field, '"') || strchr(field, '\n') || strchr(field, '\r');
         if (needs_quotes) fputc('"', fp);
         for (const char *c = field; *c; c++) {
             if (*c == '"') fputc('"', fp); // escape quotes
@@ -133,78 +47,324 @@ static inline int csv_append_row(const char *filename, char **fields, size_t cou
     return 1;
 }
 
-static inline CSVTable csv_read_all(const char *filename, char delimiter) {
-    CSVTable table = {NULL, 0};
-    FILE *fp = fopen(filename, "r");
-    if (!fp) return table;
-    size_t capacity = ROW_CAPACITY;
-    table.rows = malloc(capacity * sizeof(CSVRow));
-    char *line = NULL;
-    size_t len = 0;
-    ssize_t read;
-
-    while ((read = getline(&line, &len, fp)) != -1) {
-        if (table.count >= capacity) {
-            capacity *= 2;
-            table.rows = realloc(table.rows, capacity * sizeof(CSVRow));
+/* Growable output buffer, lets callers batch many rows into one write */
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} CSVBuffer;
+
+static inline int csv_buffer_reserve(CSVBuffer *buf, size_t extra) {
+    if (buf->len + extra <= buf->cap) return 1;
+    size_t cap = buf->cap ? buf->cap : 4096;
+    while (cap < buf->len + extra) cap *= 2;
+    char *data = realloc(buf->data, cap);
+    if (!data) return 0;
+    buf->data = data;
+    buf->cap = cap;
+    return 1;
+}
+
+static inline int csv_buffer_add_row(CSVBuffer *buf, char **fields, size_t count, char delimiter) {
+    for (size_t i = 0; i < count; i++) {
+        const char *field = fields[i];
+        size_t len = strlen(field);
+        int needs_quotes = strchr(field, delimiter) || strchr(field, '"') || strchr(field, '\n') || strchr(field, '\r');
+        if (!csv_buffer_reserve(buf, len * 2 + 4)) return 0; //worst case every char is a quote
+        if (needs_quotes) buf->data[buf->len++] = '"';
+        for (const char *c = field; *c; c++) {
+            if (*c == '"') buf->data[buf->len++] = '"'; // escape quotes
+            buf->data[buf->len++] = *c;
         }
-        // trim newline
-        if (read > 0 && (line[read - 1] == '\n' || line[read - 1] == '\r'))
-            line[--read] = '\0';
-        table.rows[table.count++] = csv_parse_line(line, delimiter);
+        if (needs_quotes) buf->data[buf->len++] = '"';
+        if (i < count - 1) buf->data[buf->len++] = delimiter;
     }
+    if (!csv_buffer_reserve(buf, 1)) return 0;
+    buf->data[buf->len++] = '\n';
+    return 1;
+}
 
-    free(line);
-    fclose(fp);
-    return table;
+/* Append the whole buffer with a single write */
+static inline int csv_append_buffer(const char *filename, const CSVBuffer *buf) {
+    if (buf->len == 0) return 1;
+    FILE *fp = fopen(filename, "a");
+    if (!fp) return 0;
+    size_t written = fwrite(buf->data, 1, buf->len, fp);
+    if (fclose(fp) != 0) return 0;
+    return written == buf->len;
 }
 
-static inline void csv_free_table(CSVTable *table) {
-    for (size_t i = 0; i < table->count; i++)
-        csv_free_row(&table->rows[i]);
-    free(table->rows);
-    table->rows = NULL;
-    table->count = 0;
+static inline void csv_buffer_free(CSVBuffer *buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
 }
 
-static inline int csv_remove_row(const char *filename, const int column, const char *target,char delimiter) {
-    CSVTable table = csv_read_all(filename, delimiter);
-    if(!table.rows || table.count == 0) return 0;
+/* Streaming parser (RFC 4180): fields are handed out as borrowed, NUL
+   terminated slices of the read buffer with quotes already unescaped.
+   Quoted fields may span lines. A row's slices stay valid until its
+   on_row returns. Callbacks return 0 to stop parsing early. */
+#define CSV_STREAM_CHUNK (64 * 1024)
+
+typedef int (*csv_field_cb)(const char *field, size_t len, size_t col, void *ctx);
+typedef int (*csv_row_cb)(size_t row, size_t field_count, void *ctx);
+
+// tokenizer states
+enum {
+    CSV_S_FIELD,        // start of a field
+    CSV_S_UNQUOTED,     // inside an unquoted field
+    CSV_S_QUOTED,       // inside a quoted field
+    CSV_S_QUOTE,        // quote seen inside a quoted field: end or escape
+    CSV_S_CR,           // row ended on \r, swallow a following \n
+    CSV_STATE_COUNT
+};
+
+// character classes
+enum {
+    CSV_C_OTHER,
+    CSV_C_DELIM,
+    CSV_C_QUOTE,
+    CSV_C_CR,
+    CSV_C_LF,
+    CSV_CLASS_COUNT
+};
+
+// actions
+enum {
+    CSV_A_SKIP,         // drop the char
+    CSV_A_COPY,         // append the char to the field
+    CSV_A_FIELD,        // end the field
+    CSV_A_ROW           // end the field and the row
+};
+
+typedef struct {
+    unsigned char next;
+    unsigned char action;
+} CSVTransition;
+
+static const CSVTransition csv_transitions[CSV_STATE_COUNT][CSV_CLASS_COUNT] = {
+    [CSV_S_FIELD] = {
+        [CSV_C_OTHER] = {CSV_S_UNQUOTED, CSV_A_COPY},
+        [CSV_C_DELIM] = {CSV_S_FIELD,    CSV_A_FIELD},
+        [CSV_C_QUOTE] = {CSV_S_QUOTED,   CSV_A_SKIP},
+        [CSV_C_CR]    = {CSV_S_CR,       CSV_A_ROW},
+        [CSV_C_LF]    = {CSV_S_FIELD,    CSV_A_ROW},
+    },
+    [CSV_S_UNQUOTED] = {
+        [CSV_C_OTHER] = {CSV_S_UNQUOTED, CSV_A_COPY},
+        [CSV_C_DELIM] = {CSV_S_FIELD,    CSV_A_FIELD},
+        [CSV_C_QUOTE] = {CSV_S_UNQUOTED, CSV_A_COPY},   // stray quote, keep literally
+        [CSV_C_CR]    = {CSV_S_CR,       CSV_A_ROW},
+        [CSV_C_LF]    = {CSV_S_FIELD,    CSV_A_ROW},
+    },
+    [CSV_S_QUOTED] = {
+        [CSV_C_OTHER] = {CSV_S_QUOTED,   CSV_A_COPY},
+        [CSV_C_DELIM] = {CSV_S_QUOTED,   CSV_A_COPY},
+        [CSV_C_QUOTE] = {CSV_S_QUOTE,    CSV_A_SKIP},
+        [CSV_C_CR]    = {CSV_S_QUOTED,   CSV_A_COPY},
+        [CSV_C_LF]    = {CSV_S_QUOTED,   CSV_A_COPY},
+    },
+    [CSV_S_QUOTE] = {
+        [CSV_C_OTHER] = {CSV_S_UNQUOTED, CSV_A_COPY},   // "ab"c -> abc
+        [CSV_C_DELIM] = {CSV_S_FIELD,    CSV_A_FIELD},
+        [CSV_C_QUOTE] = {CSV_S_QUOTED,   CSV_A_COPY},   // "" -> "
+        [CSV_C_CR]    = {CSV_S_CR,       CSV_A_ROW},
+        [CSV_C_LF]    = {CSV_S_FIELD,    CSV_A_ROW},
+    },
+    [CSV_S_CR] = {
+        [CSV_C_OTHER] = {CSV_S_UNQUOTED, CSV_A_COPY},
+        [CSV_C_DELIM] = {CSV_S_FIELD,    CSV_A_FIELD},
+        [CSV_C_QUOTE] = {CSV_S_QUOTED,   CSV_A_SKIP},
+        [CSV_C_CR]    = {CSV_S_CR,       CSV_A_ROW},
+        [CSV_C_LF]    = {CSV_S_FIELD,    CSV_A_SKIP},   // \r\n
+    },
+};
+
+// word-at-a-time search: nonzero if any byte of w equals the byte repeated in pattern
+#define CSV_ONES  0x0101010101010101ULL
+#define CSV_HIGHS 0x8080808080808080ULL
+static inline uint64_t csv_has_byte(uint64_t w, uint64_t pattern) {
+    uint64_t x = w ^ pattern;
+    return (x - CSV_ONES) & ~x & CSV_HIGHS;
+}
 
-    CSVTable filtered = { malloc(table.count * sizeof(CSVRow)), 0};
-    int removed = 0;
+// fast path for unquoted fields: skip to the next delimiter, \r or \n
+static inline const char *csv_scan_unquoted(const char *p, const char *end, char delimiter) {
+    const uint64_t d  = CSV_ONES * (uint8_t)delimiter;
+    const uint64_t cr = CSV_ONES * (uint8_t)'\r';
+    const uint64_t lf = CSV_ONES * (uint8_t)'\n';
+    while (end - p >= 8) {
+        uint64_t w;
+        memcpy(&w, p, 8);
+        if (csv_has_byte(w, d) | csv_has_byte(w, cr) | csv_has_byte(w, lf)) break;
+        p += 8;
+    }
+    while (p < end && *p != delimiter && *p != '\r' && *p != '\n') p++;
+    return p;
+}
 
-    for(size_t i = 0; i < table.count; i++) {
-        CSVRow *row = &table.rows[i];
+typedef struct {
+    char delimiter;
+    unsigned char cls[256];     // char -> class
+    int state;
+    size_t row;
+    char *row_start;            // first byte of the current row in buf
+    char *out;                  // write position, unescaping compacts in place
+    size_t *ends;               // end offsets of finished fields, relative to row_start
+    size_t nfields;
+    size_t cap_fields;
+    int row_has_data;
+    csv_field_cb on_field;
+    csv_row_cb on_row;
+    void *ctx;
+} CSVStream;
+
+static inline int csv_stream_end_field(CSVStream *s) {
+    if (s->nfields == s->cap_fields) {
+        size_t cap = s->cap_fields ? s->cap_fields * 2 : 8;
+        size_t *ends = realloc(s->ends, cap * sizeof(size_t));
+        if (!ends) return 0;
+        s->ends = ends;
+        s->cap_fields = cap;
+    }
+    *s->out = '\0';     // always lands on a consumed byte, never past the input
+    s->ends[s->nfields++] = s->out - s->row_start;
+    s->out++;
+    return 1;
+}
 
-        if(i == 0) { //preserve header
-            filtered.rows[filtered.count++] = *row;
-            continue;
+static inline int csv_stream_end_row(CSVStream *s, char *next_row) {
+    int ok = 1;
+    size_t count = s->row_has_data ? s->nfields : 0;
+    size_t begin = 0;
+    for (size_t i = 0; i < count && ok; i++) {
+        if (s->on_field)
+            ok = s->on_field(s->row_start + begin, s->ends[i] - begin, i, s->ctx);
+        begin = s->ends[i] + 1;
+    }
+    if (ok && s->on_row) ok = s->on_row(s->row, count, s->ctx);
+    s->row++;
+    s->nfields = 0;
+    s->row_has_data = 0;
+    s->row_start = s->out = next_row;
+    return ok;
+}
+
+// run the state machine over [p, end). returns 0 if a callback stopped parsing
+static inline int csv_stream_feed(CSVStream *s, char *p, char *end) {
+    while (p < end) {
+        // fast paths: bulk copy runs of plain chars
+        if (s->state == CSV_S_UNQUOTED || s->state == CSV_S_QUOTED) {
+            const char *stop = s->state == CSV_S_UNQUOTED
+                ? csv_scan_unquoted(p, end, s->delimiter)
+                : memchr(p, '"', end - p);
+            if (!stop) stop = end;
+            size_t n = stop - p;
+            if (n) {
+                if (s->out != p) memmove(s->out, p, n);
+                s->out += n;
+                p += n;
+                continue;
+            }
         }
 
-        if(column < (int)row->count && strcmp(row->fields[column], target) == 0) {
-            removed = 1; //found
-            continue;
+        const CSVTransition t = csv_transitions[s->state][s->cls[(uint8_t)*p]];
+        s->state = t.next;
+        switch (t.action) {
+        case CSV_A_COPY:
+            *s->out++ = *p;
+            s->row_has_data = 1;
+            break;
+        case CSV_A_FIELD:
+            s->row_has_data = 1;
+            if (!csv_stream_end_field(s)) return 0;
+            break;
+        case CSV_A_ROW:
+            if (!csv_stream_end_field(s)) return 0;
+            if (!csv_stream_end_row(s, p + 1)) return 0;
+            break;
+        default:
+            if (s->state == CSV_S_QUOTED) s->row_has_data = 1;
+            break;
         }
+        p++;
 
-        filtered.rows[filtered.count++] = *row;
+        if (s->state == CSV_S_FIELD && t.action == CSV_A_SKIP) s->row_start = s->out = p; // swallowed \n of \r\n
     }
+    return 1;
+}
 
-    FILE *fp = fopen(filename, "w"); //truncate
-    if(!fp) {
-        free(filtered.rows);
+static inline int csv_parse_stream(const char *filename, char delimiter,
+                                   csv_field_cb on_field, csv_row_cb on_row, void *ctx) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) return 0;
+
+    size_t cap = CSV_STREAM_CHUNK;
+    char *buf = malloc(cap + 1); // +1 for the terminator of the last field
+    if (!buf) {
+        fclose(fp);
         return 0;
     }
-    fclose(fp);
 
-    for (size_t i = 0; i < filtered.count; i++) {
-        csv_append_row(filename, filtered.rows[i].fields, filtered.rows[i].count, delimiter);
+    CSVStream s;
+    memset(&s, 0, sizeof(s));
+    s.delimiter = delimiter;
+    s.cls[(uint8_t)delimiter] = CSV_C_DELIM;
+    s.cls['"'] = CSV_C_QUOTE;
+    s.cls['\r'] = CSV_C_CR;
+    s.cls['\n'] = CSV_C_LF;
+    s.state = CSV_S_FIELD;
+    s.row_start = s.out = buf;
+    s.on_field = on_field;
+    s.on_row = on_row;
+    s.ctx = ctx;
+
+    size_t len = 0;     // bytes in buf
+    size_t parsed = 0;  // bytes of buf already fed
+    int ok = 1;
+
+    for (;;) {
+        size_t got = fread(buf + len, 1, cap - len, fp);
+        len += got;
+        if (got == 0) break;
+
+        ok = csv_stream_feed(&s, buf + parsed, buf + len);
+        if (!ok) break;
+        parsed = len;
+
+        // move the unfinished row (already partly compacted) to the front
+        size_t keep = s.row_start - buf;
+        if (keep > 0) {
+            memmove(buf, s.row_start, len - keep);
+            s.out -= keep;
+            s.row_start = buf;
+            len -= keep;
+            parsed -= keep;
+        } else if (len == cap) {
+            // a single row fills the buffer
+            size_t out_off = s.out - buf;
+            char *grown = realloc(buf, cap * 2 + 1);
+            if (!grown) { ok = 0; break; }
+            s.out = grown + out_off;
+            s.row_start = grown;
+            buf = grown;
+            cap *= 2;
+        }
     }
 
-    free(filtered.rows);
-    free(table.rows);  // free if dynamically allocated
+    // a read error is not the end of the file
+    if (ferror(fp)) ok = 0;
 
-    return removed;
+    // last row without a trailing newline
+    if (ok && (s.row_has_data || s.nfields > 0)) {
+        ok = csv_stream_end_field(&s) && csv_stream_end_row(&s, s.out);
+    }
+
+    free(s.ends);
+    free(buf);
+    fclose(fp);
+    return ok;
 }
 
 #endif // CSV_H
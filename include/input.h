@@ -0,0 +1,79 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// pad input for every connected controller. input_poll reads all pads once
+// per frame and turns button changes into a queue of events; a held
+// direction repeats after a delay, faster the longer it is held. buttons
+// held on several pads at once count as one.
+
+// in dispatch priority, see main.c
+typedef enum {
+    INPUT_SELECT,
+    INPUT_CROSS,
+    INPUT_CIRCLE,
+    INPUT_SQUARE,
+    INPUT_TRIANGLE,
+    INPUT_START,
+    INPUT_UP,
+    INPUT_DOWN,
+    INPUT_LEFT,
+    INPUT_RIGHT,
+    INPUT_L1,
+    INPUT_R1,
+    INPUT_L2,
+    INPUT_R2,
+    INPUT_L3,
+    INPUT_R3,
+    INPUT_BUTTON_COUNT
+} input_button_t;
+
+#define INPUT_BIT(b)    (1u << (b))
+
+typedef enum {
+    INPUT_PRESS,
+    INPUT_RELEASE,
+    INPUT_REPEAT        // button still held, act as if pressed again
+} input_event_type_t;
+
+typedef struct {
+    input_event_type_t type;
+    input_button_t button;
+} input_event_t;
+
+typedef struct {
+    uint32_t repeat_mask;       // INPUT_BIT()s of the buttons that repeat
+    uint32_t repeat_delay_ms;   // hold this long before the first repeat
+    uint32_t repeat_start_ms;   // first repeat interval
+    uint32_t repeat_min_ms;     // interval never drops below this
+    uint32_t repeat_accel;      // percent each interval keeps of the last, 100 = no acceleration
+    uint32_t scroll_max_rows;   // rows per second at full stick deflection
+} input_config_t;
+
+// config may be NULL for the defaults. calls platform_pad_init
+void input_init(const input_config_t *config);
+void input_end(void);
+
+// read every connected pad and queue what changed since the last poll
+void input_poll(void);
+
+// pop the oldest event. returns 1 if there was one
+int  input_next(input_event_t *event);
+
+// buttons held on any pad as of the last poll, one INPUT_BIT per button
+uint32_t input_held(void);
+
+// whole rows the left stick scrolled since the last call, negative is up.
+// speed grows with deflection, fractions carry over between frames
+int  input_scroll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INPUT_H
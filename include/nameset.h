@@ -0,0 +1,30 @@
+#ifndef NAMESET_H
+#define NAMESET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// case-folded hash set of profile names, open addressing w/ linear probing
+typedef struct {
+    char   **slots;     // NULL = empty, tombstone marker = deleted
+    size_t   capacity;  // always a power of two
+    size_t   count;     // live entries
+    size_t   used;      // live + tombstones
+} nameset_t;
+
+int  nameset_init(nameset_t *set, size_t capacity);
+void nameset_free(nameset_t *set);
+
+int  nameset_contains(const nameset_t *set, const char *name);
+int  nameset_add(nameset_t *set, const char *name);
+int  nameset_remove(nameset_t *set, const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NAMESET_H
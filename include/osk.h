@@ -1,11 +1,25 @@
 #ifndef OSK_H
 #define OSK_H
 
-#include <sysutil/osk.h>
+#include <stdint.h>
 
-void utf16_to_8(u16 *stw, u8 *stb);
-void utf8_to_16(u8 *stb, u16 *stw);
-int get_osk_string(char *caption, char *str, int len);
+void utf16_to_8(uint16_t *stw, uint8_t *stb);
+void utf8_to_16(uint8_t *stb, uint16_t *stw);
+//the first edit opens the session, close is registered with atexit
+int osk_session_open(void);
+void osk_session_close(void);
+
+//edits don't block: osk_begin shows the keyboard over whatever is drawn and
+//returns, then osk_poll is called once per frame after platform_poll_system.
+//on OSK_EDIT_DONE the text has been written to str (at most len bytes)
+#define OSK_EDIT_NONE       0   //no edit in progress
+#define OSK_EDIT_PENDING    1
+#define OSK_EDIT_DONE       2
+#define OSK_EDIT_CANCELED   3   //str is untouched
+
+int osk_begin(const char *caption, char *str, int len);
+int osk_poll(void);
+int osk_active(void);
 
 #endif //OSK_H
 
@@ -0,0 +1,47 @@
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// background writer for the profile csv. the ui thread enqueues row
+// operations and returns immediately; the persister thread drains the
+// queue in bursts and applies each burst as one append or one rewrite.
+// rows are keyed by their first field.
+
+// finishes a rewrite interrupted between removing the old file and renaming
+// path.tmp over it. call before anything else opens or creates path.
+// returns 1 if the temp file was moved into place
+int  persist_recover(const char *path);
+
+int  persist_start(const char *path, char delimiter, char **header, size_t header_count);
+void persist_stop(void);    // flushes pending operations, then joins
+
+int  persist_add(char **fields, size_t count);
+int  persist_remove(const char *key);
+
+// runs fn(ctx) on the persister thread with the burst it was queued in, for
+// other small writes that shouldn't block the ui. fn owns ctx. persist_stop
+// runs whatever is still queued
+typedef void (*persist_fn_t)(void *ctx);
+int  persist_run(persist_fn_t fn, void *ctx);
+
+// runs fn(ctx) on the persister thread after every burst that wrote path,
+// once the new contents are complete on disk. lets the owner tell its own
+// writes from edits made by something else. set before persist_start
+void persist_on_write(persist_fn_t fn, void *ctx);
+
+// 1 when nothing is queued or being written, i.e. the file matches what was enqueued
+int  persist_idle(void);
+
+// copies the oldest unreported error into msg. returns 1 if there was one
+int  persist_poll_error(char *msg, size_t msg_size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PERSIST_H
@@ -0,0 +1,80 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdint.h>
+
+#include "input.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// everything the ui needs from the machine it runs on. platform_ps3.c wraps
+// tiny3d, libfont, ioPad and lv2; host/platform_host.c records the same calls
+// so main.c can be replayed and timed on a pc.
+
+// prefix for every file the app touches. the host build points it at a
+// sandbox directory so /dev_flash2 and friends never mean the real thing
+#ifndef PLATFORM_ROOT
+#define PLATFORM_ROOT       ""
+#endif
+
+#define PLATFORM_PADS       7   // what ioPadInit is asked for
+
+// argc/argv as main got them, the console ignores both
+void platform_init(int argc, char **argv);
+// 0 once the app should wind down without the user asking (host replay ran out)
+int  platform_running(void);
+
+// monotonic, microseconds
+uint64_t platform_time_us(void);
+// stand in for a frame that wasn't drawn
+void platform_idle(uint32_t us);
+// work the app runs on its own threads (file writes, the registry commit).
+// the host replay waits until busy() returns 0 before its clock moves a
+// frame, so a run doesn't depend on disk speed; the console never waits
+void platform_set_background(int (*busy)(void));
+
+// graphics, 848x512 2d, z grows towards the viewer
+void  platform_gfx_init(void);
+void  platform_font_init(void);     // texture upload and font defaults, slow
+void  platform_clear(uint32_t color);
+void  platform_flip(void);          // present, waits for vblank on the console
+void  platform_quad(float x, float y, float w, float h, uint32_t color, float z);
+
+// text in the current font. return the x after the last glyph
+float platform_text(float x, float y, const char *str);
+float platform_textf(float x, float y, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+void  platform_text_color(uint32_t color, uint32_t bkcolor);
+void  platform_text_center(int on);
+
+// pads
+#define PLATFORM_PAD_NONE   0   // nothing connected on the port
+#define PLATFORM_PAD_SAME   1   // connected, no new report since the last read
+#define PLATFORM_PAD_NEW    2
+
+typedef struct {
+    uint32_t buttons;   // INPUT_BIT()s
+    uint16_t stick_v;   // left stick vertical, 0x80 at rest
+} platform_pad_t;
+
+void platform_pad_init(void);
+void platform_pad_end(void);
+// ports are read in order from 0 every poll, port 0 refreshes which are connected
+int  platform_pad_read(int port, platform_pad_t *pad);
+
+// system
+void platform_net_init(void);       // network and netDebug
+void platform_poll_system(void);    // sysutil callbacks, the keyboard's included
+// 1 while the system draws over the app (xmb, system dialogs). they are
+// composited on flip, so the loop has to keep presenting until it closes
+int  platform_overlay_open(void);
+void platform_ring_buzzer(int beeps);
+int  platform_soft_reboot(void);
+void platform_exit(void);           // last call before main returns
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLATFORM_H
@@ -0,0 +1,68 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// frame profiler: scoped timers on the ppu timebase, a rolling window of
+// frame times and per-frame draw counters. while disabled a scope costs one
+// branch and a draw costs two adds, nothing reads the timebase.
+
+typedef enum {
+    PROF_INPUT,     // pad poll and dispatch
+    PROF_TABLE,     // draw_profile_table
+    PROF_CONTROLS,  // draw_controls_box
+    PROF_TEXT,      // DrawString/DrawFormatString, overlaps the ones above
+    PROF_FLIP,      // tiny3d_Flip, includes the vblank wait
+    PROF_SCOPE_COUNT
+} prof_scope_t;
+
+#define PROF_HISTORY    256     // frames kept for the percentiles
+
+typedef struct {
+    float fps;
+    float p50_ms;
+    float p99_ms;
+    uint32_t draw_calls;        // last frame
+    uint32_t vertices;
+    float scope_ms[PROF_SCOPE_COUNT];
+} prof_stats_t;
+
+extern int prof_on;
+extern uint64_t prof_scope_start[PROF_SCOPE_COUNT];
+extern uint64_t prof_scope_ticks[PROF_SCOPE_COUNT];
+extern uint32_t prof_draw_calls;
+extern uint32_t prof_vertices;
+
+uint64_t prof_ticks(void);
+
+static inline void prof_begin(prof_scope_t scope) {
+    if (prof_on) prof_scope_start[scope] = prof_ticks();
+}
+
+static inline void prof_end(prof_scope_t scope) {
+    if (prof_on) prof_scope_ticks[scope] += prof_ticks() - prof_scope_start[scope];
+}
+
+// one tiny3d_SetPolygon..tiny3d_End
+static inline void prof_draw(uint32_t vertices) {
+    prof_draw_calls++;
+    prof_vertices += vertices;
+}
+
+void prof_toggle(void);
+
+// call once after each presented frame. closes the frame's scopes and counters
+void prof_frame(void);
+
+// numbers for the overlay, refreshed every few frames
+void prof_stats(prof_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,53 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// frame scheduler on platform_time_us. tasks are callbacks with a deadline:
+// periodic ones on a fixed timestep, one-shots at a time or after a delay,
+// and deferred ones on the next run. sched_run is called once per frame on
+// the ui thread and is the only place callbacks run, so they may touch ui
+// state and schedule or cancel other tasks, themselves included.
+
+#define SCHED_MAX_TASKS     16
+#define SCHED_MAX_CATCHUP   4   // missed periodic ticks made up in one run, a longer stall runs one
+
+typedef int sched_id_t;     // 0 is never a valid id
+#define SCHED_NONE          0
+
+typedef void (*sched_fn_t)(void *ctx);
+
+// ticks at start + n * interval_us from now on, a late frame doesn't shift
+// the ones after it. returns SCHED_NONE when every slot is taken
+sched_id_t sched_every(uint64_t interval_us, sched_fn_t fn, void *ctx);
+// once, at deadline_us on the platform_time_us clock
+sched_id_t sched_at(uint64_t deadline_us, sched_fn_t fn, void *ctx);
+sched_id_t sched_after(uint64_t delay_us, sched_fn_t fn, void *ctx);
+// once, on the next sched_run (not the current one when called from a task)
+sched_id_t sched_defer(sched_fn_t fn, void *ctx);
+
+// stale and SCHED_NONE ids are ignored. always returns SCHED_NONE, so
+// id = sched_cancel(id) leaves nothing dangling
+sched_id_t sched_cancel(sched_id_t id);
+int  sched_pending(sched_id_t id);
+
+// run every task that is due, earliest deadline first
+void sched_run(void);
+
+// clock at the start of the current or last sched_run, and the time since
+// the run before it. one timestamp per frame for everything drawn from it
+uint64_t sched_now(void);
+uint64_t sched_frame_us(void);
+
+// how long the loop may sleep before a task is due, at most max_us
+uint32_t sched_idle_us(uint32_t max_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCHED_H
@@ -0,0 +1,36 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stddef.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// append-only usage log, one "name,last_used,use_count" row per apply.
+// a later row for the same name replaces an earlier one, so recording an
+// apply is a single small append; stats_rewrite compacts the log.
+
+typedef struct {
+    const char *name;
+    time_t last_used;
+    int use_count;
+} stats_entry_t;
+
+// called for every row in file order, return 0 to stop
+typedef int (*stats_row_cb)(const stats_entry_t *entry, void *ctx);
+
+// rows_out (optional) receives the number of rows read, for compaction decisions.
+// a missing file loads as empty
+int stats_load(const char *path, stats_row_cb cb, void *ctx, size_t *rows_out);
+int stats_append(const char *path, const stats_entry_t *entry);
+
+// replace the log with exactly these entries, via a temp file
+int stats_rewrite(const char *path, const stats_entry_t *entries, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // STATS_H
@@ -47,6 +47,29 @@ int xreg_update_value(xreg_registry_t *reg,
                       const void *new_data,
                       size_t new_len);
 
+// text form of a value: bool/int as signed decimal, string as stored
+int xreg_get_text(const xreg_registry_t *reg, const char *key_name, char *out, size_t out_size);
+
+// longest text a string value can hold, the value can't grow in place.
+// -1 if the key is missing or not a string
+long xreg_text_capacity(const xreg_registry_t *reg, const char *key_name);
+
+// one write in a batch; text is converted according to the stored value type
+typedef struct {
+    const char *key_name;
+    const char *text;
+} xreg_write_t;
+
+// all or nothing: every write is resolved and encoded before the buffer is
+// touched, so a bad key or an oversized value leaves the registry unchanged.
+// only updates the in-memory copy; follow with a single xreg_save
+int xreg_update_batch(xreg_registry_t *reg, const xreg_write_t *writes, size_t count);
+
+// drop the writes that would leave the stored bytes exactly as they are.
+// compacts writes in place and returns how many remain, or -1 if a key is
+// missing or a value can't be encoded
+long xreg_filter_unchanged(const xreg_registry_t *reg, xreg_write_t *writes, size_t count);
+
 void xreg_free(xreg_registry_t *reg);
 
 #ifdef __cplusplus
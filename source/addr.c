@@ -0,0 +1,204 @@
+#include "addr.h"
+#include <string.h>
+
+//hex digit value + 1, 0 = not a hex digit. table avoids a branch ladder per char
+static const uint8_t hex_value[256] = {
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+    ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+    ['a'] = 11, ['b'] = 12, ['c'] = 13, ['d'] = 14, ['e'] = 15, ['f'] = 16,
+    ['A'] = 11, ['B'] = 12, ['C'] = 13, ['D'] = 14, ['E'] = 15, ['F'] = 16,
+};
+
+//dotted quad, no leading zeros (same as inet_pton)
+int addr_parse_v4(const char *s, size_t len, uint8_t out[4]) {
+    if (!s || len < 7 || len > 15) return ADDR_NONE;
+
+    const char *end = s + len;
+    for (int octet = 0; octet < 4; octet++) {
+        if (octet > 0) {
+            if (s >= end || *s != '.') return ADDR_NONE;
+            s++;
+        }
+
+        unsigned int v = 0;
+        int digits = 0;
+        while (s < end && (unsigned)(*s - '0') < 10u) {
+            v = v * 10 + (unsigned)(*s - '0');
+            digits++;
+            s++;
+        }
+        if (digits == 0 || digits > 3 || v > 255) return ADDR_NONE;
+        if (digits > 1 && s[-digits] == '0') return ADDR_NONE; //leading zero
+        out[octet] = (uint8_t)v;
+    }
+    return s == end ? ADDR_V4 : ADDR_NONE;
+}
+
+//rfc 4291 text form incl. "::" compression and a trailing dotted quad
+int addr_parse_v6(const char *s, size_t len, uint8_t out[16]) {
+    if (!s || len < 2 || len > 45) return ADDR_NONE;
+
+    uint8_t words[16] = {0};
+    const char *p = s;
+    const char *end = s + len;
+    int n = 0;          //bytes written
+    int gap = -1;       //byte index of "::"
+
+    if (*p == ':') {
+        if (p + 1 >= end || p[1] != ':') return ADDR_NONE;
+        p += 2;
+        gap = 0;
+        if (p == end) {
+            memset(out, 0, 16);
+            return ADDR_V6;
+        }
+    }
+
+    while (p < end) {
+        if (n >= 16) return ADDR_NONE;
+
+        const char *group = p;
+        unsigned int v = 0;
+        int digits = 0;
+        uint8_t h;
+        while (p < end && (h = hex_value[(uint8_t)*p]) != 0) {
+            v = (v << 4) | (unsigned)(h - 1);
+            digits++;
+            p++;
+        }
+
+        //embedded ipv4 tail
+        if (p < end && *p == '.') {
+            if (n > 12) return ADDR_NONE;
+            if (addr_parse_v4(group, (size_t)(end - group), words + n) != ADDR_V4) return ADDR_NONE;
+            n += 4;
+            p = end;
+            break;
+        }
+
+        if (digits == 0 || digits > 4) return ADDR_NONE;
+        words[n++] = (uint8_t)(v >> 8);
+        words[n++] = (uint8_t)v;
+
+        if (p == end) break;
+        if (*p != ':') return ADDR_NONE;
+        p++;
+        if (p < end && *p == ':') {
+            if (gap >= 0) return ADDR_NONE; //only one "::"
+            gap = n;
+            p++;
+        } else if (p == end) {
+            return ADDR_NONE; //trailing single colon
+        }
+    }
+
+    if (gap >= 0) {
+        if (n == 16) return ADDR_NONE; //"::" must stand for at least one group
+        int tail = n - gap;
+        memset(out, 0, 16);
+        memcpy(out, words, (size_t)gap);
+        memcpy(out + 16 - tail, words + gap, (size_t)tail);
+    } else {
+        if (n != 16) return ADDR_NONE;
+        memcpy(out, words, 16);
+    }
+    return ADDR_V6;
+}
+
+int addr_parse(const char *s, size_t len, addr_t *out) {
+    if (!s || !out) return ADDR_NONE;
+
+    //a colon anywhere in the first 5 chars can only be ipv6
+    size_t probe = len < 5 ? len : 5;
+    int v6 = memchr(s, ':', probe) != NULL;
+
+    memset(out, 0, sizeof(*out));
+    out->family = (uint8_t)(v6 ? addr_parse_v6(s, len, out->bytes)
+                               : addr_parse_v4(s, len, out->bytes));
+    return out->family;
+}
+
+size_t addr_parse_many(const char *const *strs, size_t count, addr_t *out) {
+    size_t valid = 0;
+    for (size_t i = 0; i < count; i++) {
+        const char *s = strs[i] ? strs[i] : "";
+        valid += addr_parse(s, strlen(s), &out[i]) != ADDR_NONE;
+    }
+    return valid;
+}
+
+static char *put_dec8(char *p, unsigned v) {
+    if (v >= 100) { *p++ = (char)('0' + v / 100); v %= 100; *p++ = (char)('0' + v / 10); }
+    else if (v >= 10) *p++ = (char)('0' + v / 10);
+    *p++ = (char)('0' + v % 10);
+    return p;
+}
+
+static char *put_hex16(char *p, unsigned v) {
+    static const char digits[] = "0123456789abcdef";
+    int shift = 12;
+    while (shift > 0 && ((v >> shift) & 0xF) == 0) shift -= 4; //no leading zeros
+    for (; shift >= 0; shift -= 4) *p++ = digits[(v >> shift) & 0xF];
+    return p;
+}
+
+size_t addr_format(const addr_t *addr, char *out, size_t out_size) {
+    char buf[ADDR_STRLEN];
+    char *p = buf;
+
+    if (addr && addr->family == ADDR_V4) {
+        for (int i = 0; i < 4; i++) {
+            if (i) *p++ = '.';
+            p = put_dec8(p, addr->bytes[i]);
+        }
+    } else if (addr && addr->family == ADDR_V6) {
+        unsigned words[8];
+        for (int i = 0; i < 8; i++) words[i] = (unsigned)(addr->bytes[2 * i] << 8) | addr->bytes[2 * i + 1];
+
+        //longest run of 2+ zero words becomes "::", first one wins a tie
+        int best = -1, best_len = 1;
+        for (int i = 0; i < 8;) {
+            if (words[i]) { i++; continue; }
+            int j = i;
+            while (j < 8 && !words[j]) j++;
+            if (j - i > best_len) { best = i; best_len = j - i; }
+            i = j;
+        }
+
+        //v4-mapped ::ffff:a.b.c.d keeps the dotted tail
+        int mapped = best == 0 && best_len == 5 && words[5] == 0xFFFF;
+
+        for (int i = 0; i < 8; i++) {
+            if (i == best) {
+                *p++ = ':';
+                *p++ = ':';
+                i += best_len - 1;
+                continue;
+            }
+            if (mapped && i == 6) {
+                *p++ = ':';
+                for (int k = 12; k < 16; k++) {
+                    if (k > 12) *p++ = '.';
+                    p = put_dec8(p, addr->bytes[k]);
+                }
+                break;
+            }
+            if (i > 0 && p[-1] != ':') *p++ = ':';
+            p = put_hex16(p, words[i]);
+        }
+    }
+
+    size_t len = (size_t)(p - buf);
+    if (out_size == 0) return len;
+    if (len >= out_size) len = out_size - 1;
+    memcpy(out, buf, len);
+    out[len] = '\0';
+    return len;
+}
+
+int addr_equal(const addr_t *a, const addr_t *b) {
+    if (a->family != b->family) return 0;
+    if (a->family == ADDR_V4) return memcmp(a->bytes, b->bytes, 4) == 0;
+    if (a->family == ADDR_V6) return memcmp(a->bytes, b->bytes, 16) == 0;
+    return 1;
+}
@@ -0,0 +1,146 @@
+#include "input.h"
+#include "platform.h"
+
+#include <string.h>
+
+#define INPUT_PADS          PLATFORM_PADS
+#define INPUT_QUEUE_SIZE    64
+#define STICK_CENTER        0x80
+#define STICK_DEADZONE      40      //resting sticks drift a little
+#define STICK_RANGE         (0x7F - STICK_DEADZONE)
+#define SCROLL_MAX_DT_US    100000  //a long stall shouldn't fling the list
+
+static const input_config_t input_defaults = {
+    .repeat_mask     = INPUT_BIT(INPUT_UP) | INPUT_BIT(INPUT_DOWN) |
+                       INPUT_BIT(INPUT_LEFT) | INPUT_BIT(INPUT_RIGHT) |
+                       INPUT_BIT(INPUT_L1) | INPUT_BIT(INPUT_R1),
+    .repeat_delay_ms = 400,
+    .repeat_start_ms = 120,
+    .repeat_min_ms   = 25,
+    .repeat_accel    = 85,
+    .scroll_max_rows = 60,
+};
+static input_config_t input_config;
+
+static uint32_t pad_held[INPUT_PADS];         //last valid report per port
+static uint16_t pad_stick_v[INPUT_PADS];
+static uint32_t held = 0;
+
+static uint64_t repeat_at[INPUT_BUTTON_COUNT];       //us, when a held button next repeats
+static uint64_t repeat_interval[INPUT_BUTTON_COUNT]; //us, shrinks with every repeat
+
+static input_event_t queue[INPUT_QUEUE_SIZE];
+static unsigned int queue_head = 0;
+static unsigned int queue_count = 0;
+
+static uint64_t last_poll = 0;
+static int64_t scroll_accum = 0;    //rows * SCROLL_UNIT, sign is the direction
+#define SCROLL_UNIT         ((int64_t)STICK_RANGE * STICK_RANGE * 1000000)
+
+static void push_event(input_event_type_t type, input_button_t button) {
+    if (queue_count == INPUT_QUEUE_SIZE) return; //nobody is draining, drop
+    input_event_t *ev = &queue[(queue_head + queue_count) % INPUT_QUEUE_SIZE];
+    ev->type = type;
+    ev->button = button;
+    queue_count++;
+}
+
+void input_init(const input_config_t *config) {
+    input_config = config ? *config : input_defaults;
+    if (input_config.repeat_accel > 100) input_config.repeat_accel = 100;
+
+    memset(pad_held, 0, sizeof(pad_held));
+    for (int i = 0; i < INPUT_PADS; i++) pad_stick_v[i] = STICK_CENTER;
+    held = 0;
+    queue_head = queue_count = 0;
+    scroll_accum = 0;
+    last_poll = platform_time_us();
+
+    platform_pad_init();
+}
+
+void input_end(void) {
+    platform_pad_end();
+}
+
+//left stick, whichever pad is pushed furthest. rows are only counted
+//past the deadzone and speed up with the square of the deflection
+static void poll_scroll(uint64_t dt_us) {
+    int deflection = 0;
+    for (int i = 0; i < INPUT_PADS; i++) {
+        int d = (int)pad_stick_v[i] - STICK_CENTER;
+        if ((d < 0 ? -d : d) > (deflection < 0 ? -deflection : deflection)) deflection = d;
+    }
+
+    int magnitude = (deflection < 0 ? -deflection : deflection) - STICK_DEADZONE;
+    if (magnitude <= 0) {
+        scroll_accum = 0;
+        return;
+    }
+    if (magnitude > STICK_RANGE) magnitude = STICK_RANGE;
+    if (dt_us > SCROLL_MAX_DT_US) dt_us = SCROLL_MAX_DT_US;
+
+    int64_t step = (int64_t)input_config.scroll_max_rows * magnitude * magnitude * (int64_t)dt_us;
+    if ((deflection < 0) != (scroll_accum < 0)) scroll_accum = 0; //changed direction
+    scroll_accum += deflection < 0 ? -step : step;
+}
+
+void input_poll(void) {
+    platform_pad_t pad;
+    uint64_t now = platform_time_us();
+
+    uint32_t now_held = 0;
+    for (int i = 0; i < INPUT_PADS; i++) {
+        int status = platform_pad_read(i, &pad);
+        if (status == PLATFORM_PAD_NONE) {
+            pad_held[i] = 0;
+            pad_stick_v[i] = STICK_CENTER;
+            continue;
+        }
+        //no new report, the pad is still in its last state
+        if (status == PLATFORM_PAD_NEW) {
+            pad_held[i] = pad.buttons;
+            pad_stick_v[i] = pad.stick_v;
+        }
+        now_held |= pad_held[i];
+    }
+
+    for (int b = 0; b < INPUT_BUTTON_COUNT; b++) {
+        uint32_t bit = INPUT_BIT(b);
+        if ((now_held & bit) && !(held & bit)) {
+            push_event(INPUT_PRESS, (input_button_t)b);
+            repeat_interval[b] = (uint64_t)input_config.repeat_start_ms * 1000;
+            repeat_at[b] = now + (uint64_t)input_config.repeat_delay_ms * 1000;
+        } else if (!(now_held & bit) && (held & bit)) {
+            push_event(INPUT_RELEASE, (input_button_t)b);
+        } else if ((now_held & bit) && (input_config.repeat_mask & bit) && now >= repeat_at[b]) {
+            push_event(INPUT_REPEAT, (input_button_t)b);
+            repeat_at[b] = now + repeat_interval[b]; //from now, a stalled frame doesn't burst
+            uint64_t next = repeat_interval[b] * input_config.repeat_accel / 100;
+            uint64_t min = (uint64_t)input_config.repeat_min_ms * 1000;
+            repeat_interval[b] = next > min ? next : min;
+        }
+    }
+    held = now_held;
+
+    poll_scroll(now - last_poll);
+    last_poll = now;
+}
+
+int input_next(input_event_t *event) {
+    if (queue_count == 0) return 0;
+    *event = queue[queue_head];
+    queue_head = (queue_head + 1) % INPUT_QUEUE_SIZE;
+    queue_count--;
+    return 1;
+}
+
+uint32_t input_held(void) {
+    return held;
+}
+
+int input_scroll(void) {
+    int64_t rows = scroll_accum / SCROLL_UNIT;
+    scroll_accum -= rows * SCROLL_UNIT;
+    return (int)rows;
+}
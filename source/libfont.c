@@ -8,6 +8,7 @@
 #include <stdarg.h> 
 #include "libfont2.h"
 #include "ttf_render.h"
+#include "profiler.h"
 
 struct t_font_description
 {
@@ -391,6 +392,7 @@ void DrawChar(float x, float y, float z, u8 chr)
         tiny3d_VertexPos(x     , y + dy2, z);
 
         tiny3d_End();
+        prof_draw(4);
     }
 
     y += (float) (font_datas.fonts[font_datas.current_font].fy[chr] * font_datas.sy) / (float) (font_datas.fonts[font_datas.current_font].h);
@@ -476,6 +478,7 @@ void DrawChar(float x, float y, float z, u8 chr)
     }
 
     tiny3d_End();
+    prof_draw(4);
 
 }
 
@@ -548,6 +551,7 @@ float DrawString(float x, float y, char *str)
 
     }
 
+    prof_begin(PROF_TEXT);
     while (*str) {
         
         if(*str == '\n') {
@@ -567,6 +571,7 @@ float DrawString(float x, float y, char *str)
         str++; 
     }
 
+    prof_end(PROF_TEXT);
     font_datas.X = x; font_datas.Y = y;
 
     return x;
@@ -634,6 +639,7 @@ float DrawFormatString(float x, float y, char *format, ...)
 
     }
 
+    prof_begin(PROF_TEXT);
     while (*str) {
         
         if(*str == '\n') {
@@ -654,6 +660,7 @@ float DrawFormatString(float x, float y, char *format, ...)
         str++;
     }
 
+    prof_end(PROF_TEXT);
     font_datas.X = x; font_datas.Y = y;
 
     return x;
@@ -1,27 +1,27 @@
 //std
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <stdarg.h>
 #include <ctype.h>
 #include <time.h>
-
-//net
-#include <arpa/inet.h>
-#include <net/net.h>
-
-//psl1ght
-#include <io/pad.h>
-#include <sysutil/osk.h>
-#include <sys/process.h>
-#include <tiny3d.h>
-#include <libfont2.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 //local
+#include "platform.h"
 #include "xreg.h"
 #include "debug.h"
-#include "font.h"
 #include "csv.h"
 #include "osk.h"
+#include "nameset.h"
+#include "addr.h"
+#include "persist.h"
+#include "stats.h"
+#include "input.h"
+#include "profiler.h"
+#include "sched.h"
 
 #define SUCCESS 1
 #define FAILURE 0
@@ -30,12 +30,15 @@
 #define DNS_FLAG_MANUAL     1
 #define DNS_FLAG_STRING(flag) ((flag) == DNS_FLAG_MANUAL ? "Manual" : "Automatic")
 
-#define XREG_PATH           "/dev_flash2/etc/xRegistry.sys"
-#define PROFILE_PATH        "/dev_hdd0/tmp/ezDNS.csv"
+#define XREG_PATH           PLATFORM_ROOT "/dev_flash2/etc/xRegistry.sys"
+#define PROFILE_PATH        PLATFORM_ROOT "/dev_hdd0/tmp/ezDNS.csv"
+#define STATS_PATH          PLATFORM_ROOT "/dev_hdd0/tmp/ezDNS.stats"
+#define IMPORT_FILENAME     "ezDNS_import.csv"
 
 #define DNS_FLAG_KEY        "/setting/net/dnsFlag"
 #define DNS_PRIMARY_KEY     "/setting/net/primaryDns"
 #define DNS_SECONDARY_KEY   "/setting/net/secondaryDns"
+#define NET_KEY_PREFIX      "/setting/net/"
 
 #define WHITE               0xFFFFFFFF
 #define BLACK               0x00000000
@@ -49,54 +52,188 @@
 //break main while loop
 static volatile int exit_requested = 0;
 
+//frames are only rebuilt when something on screen changed, otherwise the
+//last flipped frame stays up and the loop just polls the pad
+#define IDLE_FRAME_US       16666   //~60Hz pad polling while nothing redraws, less if a timer is due
+static int frame_dirty = 1;
+
 //error dialog
 #define ERR_RECOVERABLE     1
 #define ERR_UNRECOVERABLE   0
 
 static volatile int error_recoverable = ERR_RECOVERABLE;
 static volatile int error_dialog_buzzer = 0; //has buzzer rung this error?
-char *el1, *el2, *el3; //error line 1 2 3 
+#define ERR_LINE_SIZE       64
+static char el1[ERR_LINE_SIZE], el2[ERR_LINE_SIZE], el3[ERR_LINE_SIZE]; //error line 1 2 3 
 
-//restart_countdown
-static time_t last_update = 0;
-static int restart_countdown = 3;
+//short status line over the bottom of the table
+#define NOTICE_US           3000000
+static char notice[ERR_LINE_SIZE];      //"" while nothing is shown
+static sched_id_t notice_timer = SCHED_NONE;
 
-//pad input controls
-typedef struct {
-    int BTN_CROSS;
-    int BTN_CIRCLE;
-    int BTN_SQUARE;
-    int BTN_TRIANGLE;
-    int BTN_UP;
-    int BTN_DOWN;
-    int BTN_LEFT;
-    int BTN_RIGHT;
-    int BTN_SELECT;
-    int BTN_START;
-} PadButtons;
-
-//single press/release mode
-static PadButtons lastPad = {0};
-#define PRESSED_NOW(btn)  (paddata.btn && !lastPad.btn) 
-#define RELEASED_NOW(btn) (!paddata.btn && lastPad.btn) 
+//restart_countdown, ticks once a second while the restart dialog is up
+#define RESTART_SECONDS     3
+#define RESTART_POLL_US     50000   //registry commit check
+static int restart_countdown = RESTART_SECONDS;
+static int restart_saved = 0;
+static sched_id_t restart_tick_timer = SCHED_NONE;
+static sched_id_t restart_poll_timer = SCHED_NONE;
+
+//saving dialog: an apply that needs no reboot waits here for the same worker
+static sched_id_t saving_poll_timer = SCHED_NONE;
+static int saving_exit_after = 0;   //the save dialog asked to exit once it's written
+
+//set while a handler runs for a held button rather than a fresh press
+static int input_repeating = 0;
 
 //data structures for profiles
+//plain old data: copies, shifts and deletes never touch the allocator
+#define PROFILE_NAME_SIZE   32
+#define PROFILE_LABEL_SIZE  24  //a group name or a single tag
+#define PROFILE_TAGS_SIZE   64
+#define TAG_SEPARATOR       ';'
+#define PROFILE_SETTINGS_SIZE 256   //"key=value;key=value" under NET_KEY_PREFIX
+#define NET_SETTINGS_MAX    16
 typedef struct {
-    char* name;
+    char name[PROFILE_NAME_SIZE];
+    char group[PROFILE_LABEL_SIZE];     //"" = no group
+    char tags[PROFILE_TAGS_SIZE];       //TAG_SEPARATOR separated
+    uint32_t netSettings;   //offset in settingsPool of the extra registry keys applied with the dns ones, 0 = dns only
     int dnsFlag;
-    char* primaryDns;
-    char* secondaryDns;
+    addr_t primaryDns;      //ADDR_NONE = <auto>
+    addr_t secondaryDns;
+    time_t lastUsed;        //0 = never applied
+    int useCount;
+    int latencyMs;          //-1 = not measured
 } Values;
 
 static Values currentValues = {0}; //the values set by the system
 static Values modifiedValues = {0}; //values changed in the app
 
+//loaded once in main, handlers below reach it from here
+static xreg_registry_t *registry = NULL;
+
 static Values *savedValueList = NULL; //list of values from file
 static int savedValueCount = 0; //index ptr
+static int savedValueCapacity = 0; //allocated slots in savedValueList
+static nameset_t savedNames = {0}; //case-folded names in savedValueList, for uniqueness checks
+static int *nameIndex = NULL; //savedValueList indices sorted by name (case insensitive), for search
+
+//net settings strings live out of line so Values stays small. each distinct
+//string is stored once and profiles keep its offset, so copies still never
+//touch the allocator. offset 0 is "", nothing is removed: a console only
+//ever has a handful of distinct settings sets
+static char *settingsPool = NULL;
+static uint32_t settingsPoolLen = 0;
+static uint32_t settingsPoolCapacity = 0;
+
+static const char *profile_settings(const Values *profile) {
+    return profile->netSettings ? settingsPool + profile->netSettings : "";
+}
+
+//offset of settings in settingsPool, adding it when it's new. 0 on failure
+static uint32_t intern_settings(const char *settings) {
+    for(uint32_t off = 1; off < settingsPoolLen; off += strlen(settingsPool + off) + 1) {
+        if(strcmp(settingsPool + off, settings) == 0) return off;
+    }
+    uint32_t len = strlen(settings) + 1;
+    if(settingsPoolLen + len + 1 > settingsPoolCapacity) {
+        uint32_t capacity = settingsPoolCapacity ? settingsPoolCapacity : 256;
+        while(capacity < settingsPoolLen + len + 1) capacity *= 2;
+        char *pool = realloc(settingsPool, capacity);
+        if(!pool) return 0;
+        if(!settingsPool) pool[settingsPoolLen++] = '\0'; //offset 0
+        settingsPool = pool;
+        settingsPoolCapacity = capacity;
+    }
+    uint32_t off = settingsPoolLen;
+    memcpy(settingsPool + off, settings, len);
+    settingsPoolLen += len;
+    return off;
+}
+
+//groups and tags share one namespace of labels, each with its own name-sorted
+//list of savedValueList indices, so showing a group is a pointer swap
+typedef struct {
+    char name[PROFILE_LABEL_SIZE];
+    int *rows;
+    int count;
+    int capacity;
+    int sorted;     //rows before a bulk add, the rest are merged in when it ends
+} LabelIndex;
+
+static LabelIndex *labelIndex = NULL;
+static int labelCount = 0;
+static int labelCapacity = 0;
+static int activeLabel = -1; //-1 = all profiles
+
+//first row added since begin_bulk_add, -1 outside one: bulk adds only append
+//and end_bulk_add sorts the new rows into every index at once
+static int bulkStart = -1;
+
+//sort orders for the unfiltered table. "Current" and "System Default" stay pinned on top
+typedef enum {
+    SORT_FILE,
+    SORT_NAME,
+    SORT_LAST_USED,
+    SORT_USE_COUNT,
+    SORT_LATENCY,
+    SORT_ORDER_COUNT
+} SortOrder;
+
+static const char *sort_order_strings[SORT_ORDER_COUNT] = {
+    [SORT_FILE]      = "File",
+    [SORT_NAME]      = "Name",
+    [SORT_LAST_USED] = "Last used",
+    [SORT_USE_COUNT] = "Most used",
+    [SORT_LATENCY]   = "Latency",
+};
+
+static SortOrder sortOrder = SORT_LAST_USED; //most recently applied first
+static int *sortIndex = NULL; //rows from 2 on, in sortOrder; empty for SORT_FILE
+static int sortIndexCount = 0;
+
+//metric_sort's key arrays, kept between sorts: a fresh block this big comes
+//straight from the kernel and faults in a page at a time
+typedef struct {
+    uint64_t key;
+    int idx;
+} SortKey;
+static SortKey *sortKeys = NULL;
+static int sortKeysCapacity = 0;
+
+//rows shown in the table: a run of the active index list, start -1 = every row in sortOrder
+static int tableViewStart = -1;
+static int tableViewCount = 0;
+
+static const int *view_list() {
+    return activeLabel < 0 ? nameIndex : labelIndex[activeLabel].rows;
+}
+
+int view_count() {
+    return tableViewStart < 0 ? savedValueCount : tableViewCount;
+}
+
+int view_index(int pos) {
+    if(tableViewStart >= 0) return view_list()[tableViewStart + pos];
+    if(sortOrder == SORT_FILE || pos < 2) return pos;
+    return sortIndex[pos - 2];
+}
+
+//type-ahead search: prefix is built one char at a time from the wheel
+static const char search_wheel[] = "abcdefghijklmnopqrstuvwxyz0123456789 -_.";
+#define SEARCH_WHEEL_SIZE   ((int)sizeof(search_wheel) - 1)
+static char search_buf[PROFILE_NAME_SIZE];
+static int search_len = 0;
+static int search_wheel_pos = 0;
 
 //cursor position in table
 static volatile int cur_pos = 0;
-static volatile Values curPosValues = {0};
+static Values curPosValues = {0};
+static int table_scroll = 0; //first view row drawn; the window follows cur_pos
+
+//the table no longer limits how many profiles fit, it only draws the visible ones
+#define PROFILE_CAPACITY    10000
 
 //window state
 typedef enum {
@@ -107,9 +244,23 @@ typedef enum {
     STATE_DELETION_CONFIRMATION_DIALOG,
     STATE_NEW_PROFILE_DIALOG,
     STATE_FIRST_RUN_DIALOG,
-    STATE_ERROR_DIALOG
+    STATE_IMPORT_DIALOG,
+    STATE_SEARCH,
+    STATE_ERROR_DIALOG,
+    STATE_OSK,
+    STATE_SAVING_DIALOG,
+    STATE_COUNT
 } State;
 static State currentState = STATE_NO_DIALOG; 
+void set_state(State next);
+
+//system keyboard edit: the keyboard draws itself over our retained frame
+//while the state it was opened from stays drawn underneath
+typedef struct {
+    State from;
+    void (*done)(int edited);   //edited is 0 if cancelled, buf untouched
+} OskEdit;
+static OskEdit osk_edit;
 
 //form validation
 typedef enum {
@@ -122,6 +273,8 @@ typedef enum {
     SECONDARY_DNS_LENGTH,
     PRIMARY_DNS_ADDR_INVALID,
     SECONDARY_DNS_ADDR_INVALID,
+    PRIMARY_DNS_TOO_LONG,
+    SECONDARY_DNS_TOO_LONG,
     VALIDATION_STATE_COUNT 
 } ValidationState;
 
@@ -135,44 +288,18 @@ static const char *validation_state_strings[VALIDATION_STATE_COUNT] = {
     [PRIMARY_DNS_LENGTH]         = "Primary DNS address has incorrect length",
     [SECONDARY_DNS_LENGTH]       = "Secondary DNS address has incorrect length",
     [PRIMARY_DNS_ADDR_INVALID]   = "Primary DNS address is invalid",
-    [SECONDARY_DNS_ADDR_INVALID] = "Secondary DNS address is invalid"
+    [SECONDARY_DNS_ADDR_INVALID] = "Secondary DNS address is invalid",
+    [PRIMARY_DNS_TOO_LONG]       = "Primary DNS address is too long for the console",
+    [SECONDARY_DNS_TOO_LONG]     = "Secondary DNS address is too long for the console"
 };
 
 //on screen keyboard buffer for new profile form
 char osk_name_buf[20];
-char osk_primary_buf[15];
-char osk_secondary_buf[15];
-
-int sys_soft_reboot() {
-    unlink("/dev_hdd0/tmp/turnoff"); //delete turnoff file to avoid bad reboot
-    lv2syscall3(379, 0x0200, 0, 0);
-
-    return_to_user_prog(int);
-}
-
-int sys_ring_buzzer(int beeps) {
-    if (beeps < 1) beeps = 1;
-    if (beeps > 3) beeps = 3;
-
-    static const uint64_t args[3][3] = {
-        {0x1004, 0x4, 0x6},     //single beep
-        {0x1004, 0x7, 0x36},    //two beeps
-        {0x1004, 0xa, 0x1b6}    //three beeps
-    };
-
-    lv2syscall3(392, args[beeps - 1][0], args[beeps - 1][1], args[beeps - 1][2]);
-    return 0;
-}
-
-int is_valid_addr(const char *ip) {
-    struct sockaddr_in sa;
-    int result = inet_pton(AF_INET, ip, &(sa.sin_addr));
-    if (result == 1) {
-        return SUCCESS;  // valid address
-    }
-    netDebug("IP address invalid");
-    return FAILURE;     // invalid address
-}
+char osk_primary_buf[ADDR_STRLEN]; //fits any ipv4 or ipv6 text form
+char osk_secondary_buf[ADDR_STRLEN];
+char osk_group_buf[PROFILE_LABEL_SIZE];
+char osk_tags_buf[PROFILE_TAGS_SIZE];
+char osk_settings_buf[PROFILE_SETTINGS_SIZE]; //filled by capture, not typed
 
 int get_value_int(xreg_registry_t *reg, char *key_name, int *out) {
     const xreg_key_t *key = xreg_find_key(reg, key_name);
@@ -193,7 +320,8 @@ int get_value_int(xreg_registry_t *reg, char *key_name, int *out) {
 
 int get_value_string(xreg_registry_t *reg, 
                     char *key_name, 
-                    char **out) {
+                    char *out,
+                    size_t out_size) {
     const xreg_key_t *key = xreg_find_key(reg, key_name);
     if(!key) return FAILURE;
 
@@ -205,121 +333,293 @@ int get_value_string(xreg_registry_t *reg,
     while (actual_len < val->value_length && val->value_data[actual_len] != '\0') {
         actual_len++;
     }
-
-    *out = malloc(actual_len + 1);
-    if (!*out) return FAILURE;
+    if ((size_t)actual_len >= out_size) return FAILURE;
 
     for (int i = 0; i < actual_len; ++i) {
         char c = val->value_data[i];
-        (*out)[i] = (c >= 32 && c < 127) ? c : '.';
+        out[i] = (c >= 32 && c < 127) ? c : '.';
     }
-    (*out)[actual_len] = '\0';
+    out[actual_len] = '\0';
     return SUCCESS;
 }
 
-int set_value_int(xreg_registry_t *reg, 
-                    const char *key_name, 
-                    int value) {
-    if (!reg || !key_name) return FAILURE;
+//read a dns string key into binary form, empty = <auto>
+int get_value_addr(xreg_registry_t *reg, 
+                    char *key_name, 
+                    addr_t *out) {
+    char str[ADDR_STRLEN];
+    if(get_value_string(reg, key_name, str, sizeof(str)) != SUCCESS) return FAILURE;
 
-    int be_value = htonl(value); //convert to big endian
-    if (!xreg_update_value(reg, key_name, 1, &be_value, sizeof(be_value))) {
-        return FAILURE;
+    netDebug("%s: %s", key_name, str);
+    if(str[0] == '\0') {
+        memset(out, 0, sizeof(*out));
+        return SUCCESS;
     }
+    return addr_parse(str, strlen(str), out) != ADDR_NONE ? SUCCESS : FAILURE;
+}
 
-    if (!xreg_save(reg, XREG_PATH)) {
-        return FAILURE;
+//keys captured from the console into a profile, on top of the three dns keys
+static const char *net_capture_keys[] = {
+    "ipAddressFlag", "ipAddress", "netmask", "defaultRoute", "mtu",
+    "httpProxyFlag", "httpProxyServer", "httpProxyPort",
+};
+#define NET_CAPTURE_KEY_COUNT (sizeof(net_capture_keys) / sizeof(net_capture_keys[0]))
+
+//keys build_registry_plan writes from the profile's own dns fields
+static const char *net_managed_keys[] = {"dnsFlag", "primaryDns", "secondaryDns"};
+#define NET_MANAGED_KEY_COUNT (sizeof(net_managed_keys) / sizeof(net_managed_keys[0]))
+
+typedef int (*net_setting_cb)(const char *key, size_t key_len, const char *value, size_t value_len, void *ctx);
+
+static int is_managed_key(const char *key, size_t key_len) {
+    for(size_t i = 0; i < NET_MANAGED_KEY_COUNT; i++) {
+        if(strlen(net_managed_keys[i]) == key_len && memcmp(net_managed_keys[i], key, key_len) == 0) return 1;
     }
-    return SUCCESS;
+    return 0;
 }
 
-int set_value_string(xreg_registry_t *reg, 
-                    const char *key_name, 
-                    const char *str) {
-    if (!reg || !key_name || !str) return FAILURE;
+//1 if a pair in text before stop already has this key
+static int has_earlier_key(const char *text, const char *stop, const char *key, size_t key_len) {
+    for(const char *p = text; p < stop;) {
+        const char *eq = strchr(p, '=');
+        if((size_t)(eq - p) == key_len && memcmp(p, key, key_len) == 0) return 1;
+        p = strchr(p, ';') + 1; //pairs before stop are well formed
+    }
+    return 0;
+}
 
-    size_t len = strlen(str);
-    if (!xreg_update_value(reg, key_name, 2, str, len)) {
-        return FAILURE;
+//walk "key=value;key=value". returns the number of pairs, or -1 if malformed
+//or cb stopped. a key may appear once, and never one of the dns keys the
+//profile's own fields write
+int net_settings_each(const char *text, net_setting_cb cb, void *ctx) {
+    int count = 0;
+    const char *p = text;
+    while(*p) {
+        const char *end = strchr(p, ';');
+        if(!end) end = p + strlen(p);
+        const char *eq = memchr(p, '=', end - p);
+        if(!eq || eq == p) return -1;
+        for(const char *k = p; k < eq; k++) {
+            if(!isalnum((unsigned char)*k)) return -1;
+        }
+        if(is_managed_key(p, eq - p) || has_earlier_key(text, p, p, eq - p)) return -1;
+        if(cb && !cb(p, eq - p, eq + 1, end - eq - 1, ctx)) return -1;
+        count++;
+        p = *end ? end + 1 : end;
     }
+    return count;
+}
+
+typedef struct {
+    char keys[NET_SETTINGS_MAX][64];
+    char values[NET_SETTINGS_MAX][128];
+    xreg_write_t writes[NET_SETTINGS_MAX + 3];
+    size_t count;
+} RegistryPlan;
+
+static int plan_net_setting(const char *key, size_t key_len, const char *value, size_t value_len, void *ctx) {
+    RegistryPlan *plan = ctx;
+    if(plan->count >= NET_SETTINGS_MAX) return 0;
+    size_t n = plan->count;
+    if(snprintf(plan->keys[n], sizeof(plan->keys[n]), "%s%.*s", NET_KEY_PREFIX, (int)key_len, key) >= (int)sizeof(plan->keys[n])) return 0;
+    if(value_len >= sizeof(plan->values[n])) return 0;
+    memcpy(plan->values[n], value, value_len);
+    plan->values[n][value_len] = '\0';
+    plan->writes[n].key_name = plan->keys[n];
+    plan->writes[n].text = plan->values[n];
+    plan->count++;
+    return 1;
+}
+
+//keys the console ignores while a flag key holds a given value. changing only
+//these still needs the registry write, but not a reboot
+typedef struct {
+    const char *key;
+    const char *flag_key;
+    const char *inactive;   //flag value that makes key inert, as xreg_get_text prints it
+} DependentKey;
+
+static const DependentKey dependent_keys[] = {
+    {DNS_PRIMARY_KEY,   DNS_FLAG_KEY, "0"}, //DNS_FLAG_AUTOMATIC: dns comes from dhcp
+    {DNS_SECONDARY_KEY, DNS_FLAG_KEY, "0"},
+};
+#define DEPENDENT_KEY_COUNT (sizeof(dependent_keys) / sizeof(dependent_keys[0]))
 
-    if (!xreg_save(reg, XREG_PATH)) {
-        return FAILURE; 
+typedef enum {
+    APPLY_INVALID,      //a key is missing or a value doesn't fit
+    APPLY_NOTHING,      //registry already matches byte for byte
+    APPLY_NO_REBOOT,    //only inert keys differ
+    APPLY_REBOOT
+} ApplyKind;
+
+//every key of the profile goes into one batch, the dns keys last so they win
+static int build_registry_plan(RegistryPlan *plan) {
+    static char flag[4];
+    static char primary[ADDR_STRLEN];
+    static char secondary[ADDR_STRLEN];
+
+    plan->count = 0;
+    if(net_settings_each(profile_settings(&modifiedValues), plan_net_setting, plan) < 0) {
+        netDebug("Malformed network settings");
+        return FAILURE;
     }
 
+    snprintf(flag, sizeof(flag), "%d", modifiedValues.dnsFlag);
+    addr_format(&modifiedValues.primaryDns, primary, sizeof(primary));
+    addr_format(&modifiedValues.secondaryDns, secondary, sizeof(secondary));
+    plan->writes[plan->count++] = (xreg_write_t){DNS_FLAG_KEY, flag};
+    plan->writes[plan->count++] = (xreg_write_t){DNS_PRIMARY_KEY, primary};
+    plan->writes[plan->count++] = (xreg_write_t){DNS_SECONDARY_KEY, secondary};
     return SUCCESS;
 }
 
-int save_modified_values(xreg_registry_t *reg) {
-    if(set_value_int(reg, DNS_FLAG_KEY, modifiedValues.dnsFlag) != SUCCESS) {
-        netDebug("Failed to set dns flag");
-        return FAILURE;
+static int is_inert_write(xreg_registry_t *reg, const xreg_write_t *write) {
+    for(size_t i = 0; i < DEPENDENT_KEY_COUNT; i++) {
+        if(strcmp(dependent_keys[i].key, write->key_name) != 0) continue;
+        char flag[16];
+        //the flag itself changing is never inert, so its stored value is the one that applies
+        return xreg_get_text(reg, dependent_keys[i].flag_key, flag, sizeof(flag)) &&
+               strcmp(flag, dependent_keys[i].inactive) == 0;
+    }
+    return 0;
+}
+
+//diff modifiedValues against reg->buffer; plan keeps only the writes that change bytes
+ApplyKind plan_modified_values(xreg_registry_t *reg, RegistryPlan *plan) {
+    if(build_registry_plan(plan) != SUCCESS) return APPLY_INVALID;
+    long changed = xreg_filter_unchanged(reg, plan->writes, plan->count);
+    if(changed < 0) return APPLY_INVALID;
+    plan->count = changed;
+    if(changed == 0) return APPLY_NOTHING;
+
+    for(size_t i = 0; i < plan->count; i++) {
+        if(!is_inert_write(reg, &plan->writes[i])) return APPLY_REBOOT;
     }
-    if(set_value_string(reg, DNS_PRIMARY_KEY, modifiedValues.primaryDns) != SUCCESS) {
-        netDebug("Failed to set primary dns");
+    return APPLY_NO_REBOOT;
+}
+
+//one batched update and one xreg_save; nothing at all for an empty plan
+int commit_registry_plan(xreg_registry_t *reg, RegistryPlan *plan) {
+    if(plan->count == 0) return SUCCESS;
+    if(!xreg_update_batch(reg, plan->writes, plan->count)) {
+        netDebug("Failed to stage registry values");
         return FAILURE;
     }
-    if(set_value_string(reg, DNS_SECONDARY_KEY, modifiedValues.secondaryDns) != SUCCESS) {
-        netDebug("Failed to set secondary dns");
+    if(!xreg_save(reg, XREG_PATH)) {
+        netDebug("Failed to write registry");
         return FAILURE;
     }
     return SUCCESS;
 }
 
-void load_texture() {
-    u32 * texture_mem = tiny3d_AllocTexture(170*1024*1024); 
-    u32 * texture_pointer;
-    if(!texture_mem) return; //whomp
-    texture_pointer = texture_mem;
-    ResetFont();
-    texture_pointer = (u32 *) AddFontFromBitmapArray((u8 *) font  , (u8 *) texture_pointer, 32, 255, 16, 32, 2, BIT0_FIRST_PIXEL);
+//every apply writes once on a worker so its dialog keeps drawing while
+//flash is busy. the main loop must not touch reg until it's done
+typedef enum {
+    COMMIT_IDLE,
+    COMMIT_RUNNING,
+    COMMIT_DONE,        //written and synced, safe to reboot
+    COMMIT_FAILED
+} CommitState;
+
+static RegistryPlan apply_plan;
+static pthread_t commit_tid;
+static pthread_mutex_t commit_lock = PTHREAD_MUTEX_INITIALIZER;
+static CommitState commit_state = COMMIT_IDLE;
+static int commit_joined = 1;
+
+static void *commit_thread(void *arg) {
+    int ok = commit_registry_plan((xreg_registry_t *)arg, &apply_plan) == SUCCESS;
+    pthread_mutex_lock(&commit_lock);
+    commit_state = ok ? COMMIT_DONE : COMMIT_FAILED;
+    pthread_mutex_unlock(&commit_lock);
+    return NULL;
 }
 
-void draw_horizontal_line(float y_pos, float thickness) {
-    tiny3d_SetPolygon(TINY3D_QUADS);
-
-    float z = 65535.0f;
+//the worker is still writing, without joining it: safe from the platform layer
+static int registry_commit_running() {
+    pthread_mutex_lock(&commit_lock);
+    int running = commit_state == COMMIT_RUNNING;
+    pthread_mutex_unlock(&commit_lock);
+    return running;
+}
 
-    tiny3d_VertexPos(0.0f, y_pos, z);
-    tiny3d_VertexColor(0xFFFFFFFF);
+//wait for the last worker if nothing has joined it yet: before reusing
+//commit_tid, and at teardown where reg is freed right after
+static void join_registry_commit() {
+    if(commit_joined) return;
+    pthread_join(commit_tid, NULL);
+    commit_joined = 1;
+}
 
-    tiny3d_VertexPos(847.0f, y_pos, z);
-    tiny3d_VertexColor(0xFFFFFFFF);
+int start_registry_commit(xreg_registry_t *reg) {
+    if(registry_commit_running()) return FAILURE;
+    join_registry_commit(); //the last worker is done, but nothing may have joined it yet
+    pthread_mutex_lock(&commit_lock);
+    commit_state = COMMIT_RUNNING;
+    pthread_mutex_unlock(&commit_lock);
+    if(pthread_create(&commit_tid, NULL, commit_thread, reg) != 0) {
+        netDebug("Failed to start registry commit");
+        pthread_mutex_lock(&commit_lock);
+        commit_state = COMMIT_FAILED;
+        pthread_mutex_unlock(&commit_lock);
+        return FAILURE;
+    }
+    commit_joined = 0;
+    return SUCCESS;
+}
 
-    tiny3d_VertexPos(847.0f, y_pos + thickness, z);
-    tiny3d_VertexColor(0xFFFFFFFF);
+//state of the last commit, joins the worker once it has finished
+CommitState registry_commit_state() {
+    pthread_mutex_lock(&commit_lock);
+    CommitState state = commit_state;
+    pthread_mutex_unlock(&commit_lock);
+    if(state != COMMIT_RUNNING && !commit_joined) {
+        pthread_join(commit_tid, NULL);
+        commit_joined = 1;
+    }
+    return state;
+}
 
-    tiny3d_VertexPos(0.0f, y_pos + thickness, z);
-    tiny3d_VertexColor(0xFFFFFFFF);
+//snapshot the capture keys the console has as "key=value;..."
+int capture_net_settings(xreg_registry_t *reg, char *out, size_t out_size) {
+    size_t len = 0;
+    out[0] = '\0';
+    for(size_t i = 0; i < NET_CAPTURE_KEY_COUNT; i++) {
+        char key[64];
+        char value[128];
+        snprintf(key, sizeof(key), "%s%s", NET_KEY_PREFIX, net_capture_keys[i]);
+        if(!xreg_get_text(reg, key, value, sizeof(value))) continue; //not on this console
+        if(strchr(value, ';')) continue; //can't be represented in the list
+
+        int n = snprintf(out + len, out_size - len, "%s%s=%s", len ? ";" : "", net_capture_keys[i], value);
+        if(n < 0 || (size_t)n >= out_size - len) {
+            out[len] = '\0';
+            return FAILURE;
+        }
+        len += n;
+    }
+    return SUCCESS;
+}
 
-    tiny3d_End();
+//text for an address cell, <auto> when unset
+char *addr_label(const addr_t *addr, char *buf, size_t size) {
+    if(addr->family == ADDR_NONE) return "<auto>";
+    addr_format(addr, buf, size);
+    return buf;
+}
 
+void draw_horizontal_line(float y_pos, float thickness) {
+    platform_quad(0.0f, y_pos, 847.0f, thickness, 0xFFFFFFFF, 65535.0f);
 }
 
 void draw_rect(float x, float y, float w, 
-                float h, u32 color, float z) {
-    tiny3d_SetPolygon(TINY3D_QUADS);
-
-    tiny3d_VertexPos(x, y, z);
-    tiny3d_VertexColor(color);
-
-    tiny3d_VertexPos(x + w, y, z);
-    tiny3d_VertexColor(color);
-
-    tiny3d_VertexPos(x + w, y + h, z);
-    tiny3d_VertexColor(color);
-
-    tiny3d_VertexPos(x, y + h, z);
-    tiny3d_VertexColor(color);
-
-    tiny3d_End();
+                float h, uint32_t color, float z) {
+    platform_quad(x, y, w, h, color, z);
 }
 
 void draw_error_dialog() {
     if(!error_recoverable) { //unrecoverable, reset values so we don't trigger the save dialog
-        modifiedValues.dnsFlag = currentValues.dnsFlag;
-        modifiedValues.primaryDns = currentValues.primaryDns;
-        modifiedValues.secondaryDns = currentValues.secondaryDns;
+        modifiedValues = currentValues;
     }
     error_dialog_buzzer = 1; //buzzer fired.
     float z = 65535.0f;
@@ -328,28 +628,28 @@ void draw_error_dialog() {
     float dialog_h = 90.0f;
     float dialog_x = (848.0f - dialog_w) / 2.0f;
     float dialog_y = (512.0f - dialog_h) / 2.0f;
-    SetFontAutoCenter(1);
+    platform_text_center(1);
 
     draw_rect(dialog_x, dialog_y, dialog_w, dialog_h, CIRCLE, z); 
     draw_rect(dialog_x+2.0f, dialog_y+2.0f, dialog_w-4.0f, dialog_h-4.0f, BLACK, z); 
 
-    DrawString(dialog_x+16.0f, dialog_y+4.0f, "An error occurred.");
+    platform_text(dialog_x+16.0f, dialog_y+4.0f, "An error occurred.");
     draw_rect(dialog_x, dialog_y+18.0f, dialog_w, 1.0f, CIRCLE, z); 
 
-    if(el1 != NULL) DrawString(dialog_x+40.0f, dialog_y+23.0f, el1);
-    if(el2 != NULL) DrawString(dialog_x+40.0f, dialog_y+37.0f, el2);
-    if(el2 != NULL) DrawString(dialog_x+40.0f, dialog_y+51.0f, el3);
+    if(el1[0]) platform_text(dialog_x+40.0f, dialog_y+23.0f, el1);
+    if(el2[0]) platform_text(dialog_x+40.0f, dialog_y+37.0f, el2);
+    if(el3[0]) platform_text(dialog_x+40.0f, dialog_y+51.0f, el3);
     draw_rect(dialog_x, dialog_y+68.0f, dialog_w, 1.0f, CIRCLE, z); 
     if(error_recoverable) { 
-        SetFontColor(SQUARE, BLACK);
-        DrawString(dialog_x+40.0f, dialog_y+72.0f, "Press Square to resume...");
-        SetFontColor(WHITE, BLACK);
+        platform_text_color(SQUARE, BLACK);
+        platform_text(dialog_x+40.0f, dialog_y+72.0f, "Press Square to resume...");
+        platform_text_color(WHITE, BLACK);
     } else {
-        SetFontColor(LIGHT_GREY, BLACK);
-        DrawString(dialog_x+40.0f, dialog_y+72.0f, "Unrecoverable. Press SELECT to exit...");
-        SetFontColor(WHITE, BLACK);
+        platform_text_color(LIGHT_GREY, BLACK);
+        platform_text(dialog_x+40.0f, dialog_y+72.0f, "Unrecoverable. Press SELECT to exit...");
+        platform_text_color(WHITE, BLACK);
     }
-    SetFontAutoCenter(0);
+    platform_text_center(0);
 }
 
 void draw_first_run_dialog() {
@@ -359,28 +659,28 @@ void draw_first_run_dialog() {
     float dialog_h = 90.0f;
     float dialog_x = (848.0f - dialog_w) / 2.0f;
     float dialog_y = (512.0f - dialog_h) / 2.0f;
-    SetFontAutoCenter(1);
+    platform_text_center(1);
 
     draw_rect(dialog_x, dialog_y, dialog_w, dialog_h, CIRCLE, z); 
     draw_rect(dialog_x+2.0f, dialog_y+2.0f, dialog_w-4.0f, dialog_h-4.0f, BLACK, z); 
 
-    DrawString(dialog_x+16.0f, dialog_y+4.0f, "Welcome to ezDNS");
+    platform_text(dialog_x+16.0f, dialog_y+4.0f, "Welcome to ezDNS");
     draw_rect(dialog_x, dialog_y+18.0f, dialog_w, 1.0f, CIRCLE, z); 
 
-    DrawString(dialog_x+40.0f, dialog_y+23.0f, "On the right are the basic controls.");
-    DrawString(dialog_x+40.0f, dialog_y+37.0f, "Support & Issues: github:tbwcjw/ps3ezDNS");
-    DrawString(dialog_x+40.0f, dialog_y+51.0f, "Thank you for using ezDNS.");
+    platform_text(dialog_x+40.0f, dialog_y+23.0f, "On the right are the basic controls.");
+    platform_text(dialog_x+40.0f, dialog_y+37.0f, "Support & Issues: github:tbwcjw/ps3ezDNS");
+    platform_text(dialog_x+40.0f, dialog_y+51.0f, "Thank you for using ezDNS.");
 
     draw_rect(dialog_x, dialog_y+68.0f, dialog_w, 1.0f, CIRCLE, z); 
 
-    SetFontColor(SQUARE, BLACK);
-    DrawString(dialog_x+40.0f, dialog_y+72.0f, "Press Square to close...");
-    SetFontColor(WHITE, BLACK);
+    platform_text_color(SQUARE, BLACK);
+    platform_text(dialog_x+40.0f, dialog_y+72.0f, "Press Square to close...");
+    platform_text_color(WHITE, BLACK);
 
-    SetFontAutoCenter(0);
+    platform_text_center(0);
 }
 
-void draw_reboot_warning() {
+void draw_reboot_warning(int saved) {
     float z = 65535.0f;
 
     float dialog_w = 300.0f;
@@ -391,13 +691,32 @@ void draw_reboot_warning() {
     draw_rect(dialog_x, dialog_y, dialog_w, dialog_h, WHITE, z); 
     draw_rect(dialog_x+2.0f, dialog_y+2.0f, dialog_w-4.0f, dialog_h-4.0f, BLACK, z); 
 
-    SetFontAutoCenter(1);                          //restart to take effect
-    DrawString(dialog_x+16.0f, dialog_y+4.0f, "Save successful!");
+    platform_text_center(1);                          //restart to take effect
+    platform_text(dialog_x+16.0f, dialog_y+4.0f, saved ? "Save successful!" : "Saving...");
     draw_rect(dialog_x, dialog_y+18.0f, dialog_w, 1.0f, WHITE, z); 
 
-    DrawFormatString(dialog_x+80.0f, dialog_y+32.0f, "Restarting in %i...", restart_countdown);
-    SetFontAutoCenter(0);
+    platform_textf(dialog_x+80.0f, dialog_y+32.0f, "Restarting in %i...", restart_countdown);
+    platform_text_center(0);
+
+}
+
+void draw_saving_dialog() {
+    float z = 65535.0f;
+
+    float dialog_w = 300.0f;
+    float dialog_h = 60.0f;
+    float dialog_x = (848.0f - dialog_w) / 2.0f;
+    float dialog_y = (512.0f - dialog_h) / 2.0f;
+
+    draw_rect(dialog_x, dialog_y, dialog_w, dialog_h, WHITE, z); 
+    draw_rect(dialog_x+2.0f, dialog_y+2.0f, dialog_w-4.0f, dialog_h-4.0f, BLACK, z); 
+
+    platform_text_center(1);
+    platform_text(dialog_x+16.0f, dialog_y+4.0f, "Saving...");
+    draw_rect(dialog_x, dialog_y+18.0f, dialog_w, 1.0f, WHITE, z); 
 
+    platform_text(dialog_x+80.0f, dialog_y+32.0f, "No restart needed.");
+    platform_text_center(0);
 }
 
 void draw_save_dialog() {
@@ -410,19 +729,19 @@ void draw_save_dialog() {
 
     draw_rect(dialog_x, dialog_y, dialog_w, dialog_h, WHITE, z); // dialog container
     draw_rect(dialog_x + 2.0f, dialog_y + 2.0f, dialog_w - 4.0f, dialog_h - 4.0f, BLACK, z); // dialog content 
-    SetFontAutoCenter(1);
-    DrawString(dialog_x + 6.0f, dialog_y + 4.0f, "Save changes?"); // header
-    SetFontAutoCenter(0);
+    platform_text_center(1);
+    platform_text(dialog_x + 6.0f, dialog_y + 4.0f, "Save changes?"); // header
+    platform_text_center(0);
     draw_rect(dialog_x, dialog_y + 18.0f, dialog_w, 1.0f, WHITE, z);  // horizontal line
 
     // Each line spaced 14.0f apart
-    SetFontColor(SQUARE, BLACK);
-    DrawString(dialog_x + 6.0f, dialog_y + 22.0f, "Square:  Discard & Exit");
-    SetFontColor(CROSS, BLACK);
-    DrawString(dialog_x + 6.0f, dialog_y + 36.0f, "Cross:   Save & Restart");
-    SetFontColor(CIRCLE, BLACK);
-    DrawString(dialog_x + 6.0f, dialog_y + 50.0f, "Circle:  Cancel & Resume");
-    SetFontColor(WHITE, BLACK);
+    platform_text_color(SQUARE, BLACK);
+    platform_text(dialog_x + 6.0f, dialog_y + 22.0f, "Square:  Discard & Exit");
+    platform_text_color(CROSS, BLACK);
+    platform_text(dialog_x + 6.0f, dialog_y + 36.0f, "Cross:   Save & Restart");
+    platform_text_color(CIRCLE, BLACK);
+    platform_text(dialog_x + 6.0f, dialog_y + 50.0f, "Circle:  Cancel & Resume");
+    platform_text_color(WHITE, BLACK);
 }
 
 void draw_deletion_confirmation_dialog() {
@@ -436,83 +755,105 @@ void draw_deletion_confirmation_dialog() {
     draw_rect(dialog_x, dialog_y, dialog_w, dialog_h, WHITE, z); // dialog container
     draw_rect(dialog_x + 2.0f, dialog_y + 2.0f, dialog_w - 4.0f, dialog_h - 4.0f, BLACK, z); // dialog content 
 
-    SetFontAutoCenter(1);
-    DrawString(dialog_x + 6.0f, dialog_y + 4.0f, "Delete this profile?"); // header
-    SetFontAutoCenter(0);
+    platform_text_center(1);
+    platform_text(dialog_x + 6.0f, dialog_y + 4.0f, "Delete this profile?"); // header
+    platform_text_center(0);
     draw_rect(dialog_x, dialog_y + 18.0f, dialog_w, 1.0f, WHITE, z);  // horizontal line
 
     float y = dialog_y + 22.0f; // starting Y position
 
-    DrawFormatString(dialog_x + 6.0f, y, "Name:   %s", curPosValues.name);
+    char addr_buf[ADDR_STRLEN];
+    platform_textf(dialog_x + 6.0f, y, "Name:   %s", curPosValues.name);
     y += 14.0f;
-    if(strlen(curPosValues.primaryDns) < 1) {
-        DrawString(dialog_x + 6.0f, y, "DNS 1:  <auto>");
-    } else {
-        DrawFormatString(dialog_x + 6.0f, y, "DNS 1:  %s", curPosValues.primaryDns);
-    }
+    platform_textf(dialog_x + 6.0f, y, "DNS 1:  %s", addr_label(&curPosValues.primaryDns, addr_buf, sizeof(addr_buf)));
     y += 14.0f;
-    if(strlen(curPosValues.secondaryDns) < 1) {
-        DrawString(dialog_x + 6.0f, y, "DNS 2:  <auto>");
-    } else {
-        DrawFormatString(dialog_x + 6.0f, y, "DNS 2:  %s", curPosValues.secondaryDns);
-    }
+    platform_textf(dialog_x + 6.0f, y, "DNS 2:  %s", addr_label(&curPosValues.secondaryDns, addr_buf, sizeof(addr_buf)));
     
 
     draw_rect(dialog_x, y + 18.0f, dialog_w, 1.0f, WHITE, z);  // horizontal line
     y += 24.0f; //skip a line
-    SetFontColor(CROSS, BLACK);
-    DrawString(dialog_x + 6.0f, y,       "Cross:  Delete");
+    platform_text_color(CROSS, BLACK);
+    platform_text(dialog_x + 6.0f, y,       "Cross:  Delete");
     y += 14.0f;
-    SetFontColor(CIRCLE, BLACK);
-    DrawString(dialog_x + 6.0f, y,       "Circle: Cancel");
+    platform_text_color(CIRCLE, BLACK);
+    platform_text(dialog_x + 6.0f, y,       "Circle: Cancel");
     y += 14.0f;
-    SetFontColor(WHITE, BLACK);
+    platform_text_color(WHITE, BLACK);
     }
 
 void draw_confirmation_dialog() {
     float z = 65535.0f;
 
     float dialog_w = 200.0f;
-    float dialog_h = 106.0f;
+    float dialog_h = 120.0f;
     float dialog_x = (848.0f - dialog_w) / 2.0f;
     float dialog_y = (512.0f - dialog_h) / 2.0f;
 
     draw_rect(dialog_x, dialog_y, dialog_w, dialog_h, WHITE, z); // dialog container
     draw_rect(dialog_x + 2.0f, dialog_y + 2.0f, dialog_w - 4.0f, dialog_h - 4.0f, BLACK, z); // dialog content 
 
-    SetFontAutoCenter(1);
-    DrawString(dialog_x + 6.0f, dialog_y + 4.0f, "Activate this profile?"); // header
-    SetFontAutoCenter(0);
+    platform_text_center(1);
+    platform_text(dialog_x + 6.0f, dialog_y + 4.0f, "Activate this profile?"); // header
+    platform_text_center(0);
     draw_rect(dialog_x, dialog_y + 18.0f, dialog_w, 1.0f, WHITE, z);  // horizontal line
 
     float y = dialog_y + 22.0f; // starting Y position
 
-    DrawFormatString(dialog_x + 6.0f, y, "Name:   %s", curPosValues.name);
+    char addr_buf[ADDR_STRLEN];
+    platform_textf(dialog_x + 6.0f, y, "Name:   %s", curPosValues.name);
     y += 14.0f;
-    if(strlen(curPosValues.primaryDns) < 1) {
-        DrawString(dialog_x + 6.0f, y, "DNS 1:  <auto>");
-    } else {
-        DrawFormatString(dialog_x + 6.0f, y, "DNS 1:  %s", curPosValues.primaryDns);
-    }
+    platform_textf(dialog_x + 6.0f, y, "DNS 1:  %s", addr_label(&curPosValues.primaryDns, addr_buf, sizeof(addr_buf)));
     y += 14.0f;
-    if(strlen(curPosValues.secondaryDns) < 1) {
-        DrawString(dialog_x + 6.0f, y, "DNS 2:  <auto>");
+    platform_textf(dialog_x + 6.0f, y, "DNS 2:  %s", addr_label(&curPosValues.secondaryDns, addr_buf, sizeof(addr_buf)));
+    y += 14.0f;
+    if(curPosValues.netSettings) {
+        platform_textf(dialog_x + 6.0f, y, "Net:    +%i keys", net_settings_each(profile_settings(&curPosValues), NULL, NULL));
     } else {
-        DrawFormatString(dialog_x + 6.0f, y, "DNS 2:  %s", curPosValues.secondaryDns);
+        platform_text(dialog_x + 6.0f, y, "Net:    DNS only");
     }
-    
 
     draw_rect(dialog_x, y + 18.0f, dialog_w, 1.0f, WHITE, z);  // horizontal line
     y += 24.0f; //skip a line
-    SetFontColor(CROSS, BLACK);
-    DrawString(dialog_x + 6.0f, y,       "Cross:  Save & Restart");
+    platform_text_color(CROSS, BLACK);
+    platform_text(dialog_x + 6.0f, y,       "Cross:  Save & Restart");
     y += 14.0f;
-    SetFontColor(CIRCLE, BLACK);
-    DrawString(dialog_x + 6.0f, y,       "Circle: Cancel & Resume");
+    platform_text_color(CIRCLE, BLACK);
+    platform_text(dialog_x + 6.0f, y,       "Circle: Cancel & Resume");
     y += 14.0f;
-    SetFontColor(WHITE, BLACK);
+    platform_text_color(WHITE, BLACK);
     }
 
+#define TABLE_ROWS          21  //rows that fit below the header
+#define TABLE_ROWS_SEARCH   20  //rows left above the search bar
+
+int search_bar_visible() {
+    return currentState == STATE_SEARCH || search_len > 0 ||
+           (currentState == STATE_OSK && osk_edit.from == STATE_SEARCH);
+}
+
+int table_visible_rows() {
+    return search_bar_visible() ? TABLE_ROWS_SEARCH : TABLE_ROWS;
+}
+
+//scroll just enough to keep cur_pos inside the window
+void follow_cursor(int visible) {
+    if(cur_pos < table_scroll) table_scroll = cur_pos;
+    if(cur_pos >= table_scroll + visible) table_scroll = cur_pos - visible + 1;
+    int max_scroll = view_count() - visible;
+    if(table_scroll > max_scroll) table_scroll = max_scroll;
+    if(table_scroll < 0) table_scroll = 0;
+}
+
+//move the cursor, clamped to the view, and select the row under it
+void set_cursor(int pos) {
+    int count = view_count();
+    if(pos >= count) pos = count - 1;
+    if(pos < 0) pos = 0;
+    cur_pos = pos;
+    if(count > 0) curPosValues = savedValueList[view_index(cur_pos)];
+    netDebug("Current pos: %i", cur_pos);
+}
+
 void draw_profile_table() {
     float z = 65535.0f;
 
@@ -527,98 +868,247 @@ void draw_profile_table() {
     draw_rect(dialog_x+1.0f, dialog_y+1.0f, dialog_w-2.0f, dialog_h-2.0f, BLACK, z); 
 
     //headers
-    DrawString(dialog_x+12.0f, dialog_y+4.0f,  "Name");
+    platform_text(dialog_x+12.0f, dialog_y+4.0f,  "Name");
     draw_rect(184.0f, dialog_y, 0.5f, dialog_h, WHITE, z);  //col divider
-    DrawString(dialog_x+196.0f, dialog_y+4.0f,  "Primary (DNS 1)");
+    platform_text(dialog_x+196.0f, dialog_y+4.0f,  "Primary (DNS 1)");
     draw_rect(383.0f, dialog_y, 0.5f, dialog_h, WHITE, z);  //col divider
-    DrawString(dialog_x+399.0f, dialog_y+4.0f,  "Secondary (DNS 2)");
+    platform_text(dialog_x+399.0f, dialog_y+4.0f,  "Secondary (DNS 2)");
     draw_rect(dialog_x, dialog_y+20.0f, dialog_w, 1.0f, WHITE, z);  //row divider
 
+    //only the rows inside the scroll window are laid out, cost doesn't grow with the list
+    int count = view_count();
+    int visible = table_visible_rows();
+    follow_cursor(visible);
+    int end = table_scroll + visible < count ? table_scroll + visible : count;
+
+    //scroll position along the right edge when the list overflows
+    if(count > visible) {
+        float track_h = visible * row_height;
+        float thumb_h = track_h * visible / count;
+        float thumb_y = dialog_y + row_height + track_h * table_scroll / count;
+        draw_rect(dialog_x+dialog_w-5.0f, thumb_y, 3.0f, thumb_h, DARK_GREY, z);
+    }
+
     //items
-    for(int i = 0; i < savedValueCount; i++) {
-        if(i == 0 && cur_pos != 0) SetFontColor(LIGHT_GREY, BLACK); //visually "disable" current profile entry
-        if(i == cur_pos) SetFontColor(CROSS, BLACK);
-        float row_y = dialog_y + row_height + i * row_height - 1.0f;
-        DrawString(dialog_x+12.0f, row_y+4.0f, savedValueList[i].name);
-        if(strcmp(savedValueList[i].primaryDns, currentValues.primaryDns) == 0) {
-            DrawString(dialog_x+188.0f, row_y+4.0f, "+");
-        }
-        if(strlen(savedValueList[i].primaryDns) < 1) {
-            DrawString(dialog_x+200.0f, row_y+4.0f, "<auto>");
-        } else {
-            DrawString(dialog_x+200.0f, row_y+4.0f, savedValueList[i].primaryDns);
+    char addr_buf[ADDR_STRLEN];
+    for(int i = table_scroll; i < end; i++) {
+        int idx = view_index(i);
+        const Values *row = &savedValueList[idx];
+        if(idx == 0 && i != cur_pos) platform_text_color(LIGHT_GREY, BLACK); //visually "disable" current profile entry
+        if(i == cur_pos) platform_text_color(CROSS, BLACK);
+        float row_y = dialog_y + row_height + (i - table_scroll) * row_height - 1.0f;
+        platform_text(dialog_x+12.0f, row_y+4.0f, row->name);
+        if(addr_equal(&row->primaryDns, &currentValues.primaryDns)) {
+            platform_text(dialog_x+188.0f, row_y+4.0f, "+");
         }
+        platform_text(dialog_x+200.0f, row_y+4.0f, addr_label(&row->primaryDns, addr_buf, sizeof(addr_buf)));
         
-        if(strcmp(savedValueList[i].secondaryDns, currentValues.secondaryDns) == 0) {
-            DrawString(dialog_x+387.0f, row_y+4.0f, "+");
+        if(addr_equal(&row->secondaryDns, &currentValues.secondaryDns)) {
+            platform_text(dialog_x+387.0f, row_y+4.0f, "+");
         }
-        if(strlen(savedValueList[i].secondaryDns) < 1) {
-            DrawString(dialog_x+399.0f, row_y+4.0f, "<auto>");
-        } else {
-            DrawString(dialog_x+399.0f, row_y+4.0f, savedValueList[i].secondaryDns);
-        }
-        SetFontColor(WHITE, BLACK);
+        platform_text(dialog_x+399.0f, row_y+4.0f, addr_label(&row->secondaryDns, addr_buf, sizeof(addr_buf)));
+        platform_text_color(WHITE, BLACK);
         draw_rect(dialog_x, row_y+row_height, dialog_w, 1.0f, WHITE, z);  //row divider
     }
 }
 
+//search prefix + wheel char along the bottom of the table
+void draw_search_bar() {
+    float z = 65535.0f;
+    float bar_x = 1.0f;
+    float bar_y = 444.0f;
+    float bar_w = 584.0f;
+    float bar_h = 37.0f;
+
+    draw_rect(bar_x, bar_y, bar_w, 1.0f, WHITE, z);
+    draw_rect(bar_x, bar_y + 1.0f, bar_w, bar_h - 1.0f, BLACK, z);
+
+    float x = platform_textf(bar_x + 11.0f, bar_y + 5.0f, "Search: %s", search_buf);
+    if(currentState == STATE_SEARCH) {
+        platform_text_color(CROSS, BLACK);
+        platform_textf(x, bar_y + 5.0f, "%c", search_wheel[search_wheel_pos]);
+        platform_text_color(WHITE, BLACK);
+    }
+    platform_textf(bar_x + 450.0f, bar_y + 5.0f, "%i match%s", view_count(), view_count() == 1 ? "" : "es");
+
+    platform_text_color(DARK_GREY, BLACK);
+    if(currentState == STATE_SEARCH) {
+        platform_text(bar_x + 11.0f, bar_y + 20.0f, "Up/Down:Char Right:Add Left:Del Square:Keyboard X:Done O:Clear");
+    } else {
+        platform_text(bar_x + 11.0f, bar_y + 20.0f, "R3: Edit search");
+    }
+    platform_text_color(WHITE, BLACK);
+}
+
+//one more frame when the notice runs out so it disappears
+void expire_notice(void *ctx) {
+    notice[0] = '\0';
+    notice_timer = SCHED_NONE;
+    frame_dirty = 1;
+}
+
+void show_notice(const char *msg) {
+    snprintf(notice, sizeof(notice), "%s", msg);
+    sched_cancel(notice_timer);
+    notice_timer = sched_after(NOTICE_US, expire_notice, NULL);
+    frame_dirty = 1;
+}
+
+void draw_notice() {
+    if(!notice[0]) return;
+    float z = 65535.0f;
+    draw_rect(1.0f, 461.0f, 584.0f, 1.0f, WHITE, z);
+    draw_rect(1.0f, 462.0f, 584.0f, 19.0f, BLACK, z);
+    platform_text_color(CROSS, BLACK);
+    platform_text(12.0f, 465.0f, notice);
+    platform_text_color(WHITE, BLACK);
+}
+
+//profiler overlay, top right over the table while on
+void draw_profiler() {
+    if(!prof_on) return;
+    static const char *scope_names[PROF_SCOPE_COUNT] = {
+        [PROF_INPUT]    = "input",
+        [PROF_TABLE]    = "table",
+        [PROF_CONTROLS] = "controls",
+        [PROF_TEXT]     = "text",
+        [PROF_FLIP]     = "flip",
+    };
+    prof_stats_t st;
+    prof_stats(&st);
+
+    float z = 65535.0f;
+    float x = 596.0f;
+    float y = 20.0f;
+    draw_rect(x, y, 240.0f, 60.0f + PROF_SCOPE_COUNT * 12.0f, WHITE, z);
+    draw_rect(x + 1.0f, y + 1.0f, 238.0f, 58.0f + PROF_SCOPE_COUNT * 12.0f, BLACK, z);
+    platform_textf(x + 6.0f, y + 4.0f, "FPS %.1f", st.fps);
+    platform_textf(x + 6.0f, y + 18.0f, "p50 %.2f ms  p99 %.2f ms", st.p50_ms, st.p99_ms);
+    platform_textf(x + 6.0f, y + 32.0f, "draws %u  verts %u", (unsigned)st.draw_calls, (unsigned)st.vertices);
+    y += 50.0f;
+    for(int i = 0; i < PROF_SCOPE_COUNT; i++, y += 12.0f) {
+        platform_textf(x + 6.0f, y, "%-9s %6.3f ms", scope_names[i], st.scope_ms[i]);
+    }
+}
+
 static volatile int cur_pos_new_profile_dialog = 0;
+#define NEW_PROFILE_FIELD_COUNT 6
 
 void draw_new_profile_dialog() {
     float z = 65535.0f;
 
     float dialog_w = 300.0f;
-    float dialog_h = 120.0f;
+    float dialog_h = 162.0f;
     float dialog_x = (848.0f - dialog_w) / 2.0f;
     float dialog_y = (512.0f - dialog_h) / 2.0f;
 
     draw_rect(dialog_x, dialog_y, dialog_w, dialog_h, WHITE, z); // dialog container
     draw_rect(dialog_x + 2.0f, dialog_y + 2.0f, dialog_w - 4.0f, dialog_h - 4.0f, BLACK, z); // dialog content 
 
-    SetFontAutoCenter(1);
-    DrawString(dialog_x + 6.0f, dialog_y + 4.0f, "Create a profile"); // header
-    SetFontAutoCenter(0);
+    platform_text_center(1);
+    platform_text(dialog_x + 6.0f, dialog_y + 4.0f, "Create a profile"); // header
+    platform_text_center(0);
     draw_rect(dialog_x, dialog_y + 18.0f, dialog_w, 1.0f, WHITE, z);  // horizontal line
 
     float y = dialog_y + 22.0f; // starting Y position
 
     if(cur_pos_new_profile_dialog == 0)  {
-        SetFontColor(CROSS, BLACK);
+        platform_text_color(CROSS, BLACK);
     } else {
-        SetFontColor(WHITE, BLACK);
+        platform_text_color(WHITE, BLACK);
     }
-    DrawFormatString(dialog_x + 6.0f, y, "Name: %s", osk_name_buf);
+    platform_textf(dialog_x + 6.0f, y, "Name: %s", osk_name_buf);
     y += 14.0f;
 
     if(cur_pos_new_profile_dialog == 1)  {
-        SetFontColor(CROSS, BLACK);
+        platform_text_color(CROSS, BLACK);
     } else {
-        SetFontColor(WHITE, BLACK);
+        platform_text_color(WHITE, BLACK);
     }
-    DrawFormatString(dialog_x + 6.0f, y, "DNS 1: %s", osk_primary_buf);
+    platform_textf(dialog_x + 6.0f, y, "DNS 1: %s", osk_primary_buf);
 
     if(cur_pos_new_profile_dialog == 2)  {
-        SetFontColor(CROSS, BLACK);
+        platform_text_color(CROSS, BLACK);
     } else {
-        SetFontColor(WHITE, BLACK);
+        platform_text_color(WHITE, BLACK);
     }
 
     y += 14.0f;
-    DrawFormatString(dialog_x + 6.0f, y, "DNS 2: %s", osk_secondary_buf);
+    platform_textf(dialog_x + 6.0f, y, "DNS 2: %s", osk_secondary_buf);
+
+    platform_text_color(cur_pos_new_profile_dialog == 3 ? CROSS : WHITE, BLACK);
+    y += 14.0f;
+    platform_textf(dialog_x + 6.0f, y, "Group: %s", osk_group_buf);
+
+    platform_text_color(cur_pos_new_profile_dialog == 4 ? CROSS : WHITE, BLACK);
+    y += 14.0f;
+    platform_textf(dialog_x + 6.0f, y, "Tags:  %s", osk_tags_buf);
+
+    platform_text_color(cur_pos_new_profile_dialog == 5 ? CROSS : WHITE, BLACK);
+    y += 14.0f;
+    if(osk_settings_buf[0]) {
+        platform_textf(dialog_x + 6.0f, y, "Network: %i keys captured", net_settings_each(osk_settings_buf, NULL, NULL));
+    } else {
+        platform_text(dialog_x + 6.0f, y, "Network: DNS only (Cross: capture)");
+    }
 
     draw_rect(dialog_x, y + 18.0f, dialog_w, 1.0f, WHITE, z);  // horizontal line
     y += 24.0f; //skip a line
-    SetFontColor(CROSS, BLACK);
-    DrawString(dialog_x + 6.0f, y,       "Cross:   Edit value");
+    platform_text_color(CROSS, BLACK);
+    platform_text(dialog_x + 6.0f, y,       "Cross:   Edit value");
     y += 14.0f;
-    SetFontColor(SQUARE, BLACK);
-    DrawString(dialog_x + 6.0f, y,       "Square:  Save");
+    platform_text_color(SQUARE, BLACK);
+    platform_text(dialog_x + 6.0f, y,       "Square:  Save");
     y += 14.0f;
-    SetFontColor(CIRCLE, BLACK);
-    DrawString(dialog_x + 6.0f, y,       "Circle:  Discard & Cancel");
+    platform_text_color(CIRCLE, BLACK);
+    platform_text(dialog_x + 6.0f, y,       "Circle:  Discard & Cancel");
     y += 14.0f;
-    SetFontColor(WHITE, BLACK);
+    platform_text_color(WHITE, BLACK);
 }
+//controls box contents, one line every 12px
+typedef struct {
+    uint32_t color;
+    const char *text;
+} ControlsLine;
+
+static const ControlsLine controls_lines[] = {
+    {LIGHT_GREY, "Start:     Create Profile"},
+    {LIGHT_GREY, "Select:    Exit ezDNS"},
+    {DARK_GREY,  "Up/Down:   Move Cursor"},
+    {DARK_GREY,  "L Stick:   Scroll"},
+    {DARK_GREY,  "Left/Right:Switch Group"},
+    {DARK_GREY,  "L1/R1:     Page Up/Down"},
+    {DARK_GREY,  "L2/R2:     Top/Bottom"},
+    {CROSS,      "Cross:     Select Profile"},
+    {CIRCLE,     "Circle:    Delete Profile"},
+    {TRIANGLE,   "Triangle:  Switch DNS Mode"},
+    {SQUARE,     "Square:    Import Profiles"},
+    {DARK_GREY,  "R3:        Search Profiles"},
+    {DARK_GREY,  "L3:        Change Sort Order"},
+    {WHITE,      ""},
+    {WHITE,      "Legend:"},
+    {WHITE,      "* = unsaved value"},
+    {WHITE,      "+ =  active value"},
+    {WHITE,      ""},
+    {WHITE,      "DNS Modes:"},
+    {WHITE,      "Automatic: DNS from DHCP, our"},
+    {WHITE,      "custom values are ignored."},
+    {WHITE,      "Manual: System uses the DNS"},
+    {WHITE,      "values that we provide."},
+    {WHITE,      ""},
+    {WHITE,      "Beeps:"},
+    {WHITE,      "1: An error occurred."},
+    {WHITE,      "2: Restarting after save."},
+    {WHITE,      ""},
+    {WHITE,      "xRegistry path:"},
+    {WHITE,      XREG_PATH},
+    {WHITE,      ""},
+    {WHITE,      "ezDNS data path:"},
+    {WHITE,      PROFILE_PATH},
+    {WHITE,      STATS_PATH},
+};
+#define CONTROLS_LINE_COUNT (sizeof(controls_lines) / sizeof(controls_lines[0]))
+
 void draw_controls_box() {
     float z = 65535.0f;
 
@@ -629,56 +1119,30 @@ void draw_controls_box() {
 
     draw_rect(dialog_x, dialog_y, dialog_w, dialog_h, WHITE, z); 
     draw_rect(dialog_x+1.0f, dialog_y+1.0f, dialog_w-2.0f, dialog_h-2.0f, BLACK, z); 
-    DrawString(dialog_x+6.0f, dialog_y+4.0f,  "Controls:");
-    SetFontColor(LIGHT_GREY, BLACK);
-    DrawString(dialog_x+6.0f, dialog_y+18.0f,  "Start:     Create Profile");
-    DrawString(dialog_x+6.0f, dialog_y+30.0f, "Select:    Exit ezDNS");
-    SetFontColor(DARK_GREY, BLACK);
-    DrawString(dialog_x+6.0f, dialog_y+42.0f, "Up/Down:   Move Cursor");
-    SetFontColor(CROSS, BLACK);
-    DrawString(dialog_x+6.0f, dialog_y+54.0f, "Cross:     Select Profile");
-    SetFontColor(CIRCLE, BLACK);
-    DrawString(dialog_x+6.0f, dialog_y+66.0f, "Circle:    Delete Profile");
-    SetFontColor(TRIANGLE, BLACK);
-    DrawString(dialog_x+6.0f, dialog_y+78.0f, "Triangle:  Switch DNS Mode");
-    SetFontColor(WHITE,BLACK);
-    DrawString(dialog_x+6.0f, dialog_y+90.0f, ""); //lb
-    DrawString(dialog_x+6.0f, dialog_y+102.0f, "Legend:"); //lb
-    DrawString(dialog_x+6.0f, dialog_y+114.0f,  "* = unsaved value");
-    DrawString(dialog_x+6.0f, dialog_y+126.0f, "+ =  active value");
-    DrawString(dialog_x+6.0f, dialog_y+138.0f, ""); //lb
-    DrawString(dialog_x+6.0f, dialog_y+150.0f, "DNS Modes:");
-    DrawString(dialog_x+6.0f, dialog_y+162.0f, "Automatic: System gets DNS");
-    DrawString(dialog_x+6.0f, dialog_y+174.0f, "values from DHCP. Our custom");
-    DrawString(dialog_x+6.0f, dialog_y+186.0f, "values will be ignored...");
-    DrawString(dialog_x+6.0f, dialog_y+198.0f, ""); //lb
-    DrawString(dialog_x+6.0f, dialog_y+198.0f, "Manual: System will use DNS");
-    DrawString(dialog_x+6.0f, dialog_y+210.0f, "info that we provide. Use");
-    DrawString(dialog_x+6.0f, dialog_y+222.0f, "this mode to set custom DNS");
-    DrawString(dialog_x+6.0f, dialog_y+234.0f, "values...");
-    DrawString(dialog_x+6.0f, dialog_y+248.0f, ""); //lb
-    DrawString(dialog_x+6.0f, dialog_y+258.0f, "Beeps:");
-    DrawString(dialog_x+6.0f, dialog_y+270.0f, "1: An error occurred. Spawned");
-    DrawString(dialog_x+6.0f, dialog_y+282.0f, "An error dialog.");
-    DrawString(dialog_x+6.0f, dialog_y+294.0f, "2: Console restarting after");
-    DrawString(dialog_x+6.0f, dialog_y+308.0f, "saving values to registry.");
-    DrawString(dialog_x+6.0f, dialog_y+320.0f, ""); //lb
-    DrawString(dialog_x+6.0f, dialog_y+332.0f, "xRegistry path:");
-    DrawString(dialog_x+6.0f, dialog_y+344.0f, XREG_PATH);
-    DrawString(dialog_x+6.0f, dialog_y+356.0f, ""); //lb
-    DrawString(dialog_x+6.0f, dialog_y+368.0f, "ezDNS data path:");
-    DrawString(dialog_x+6.0f, dialog_y+380.0f, PROFILE_PATH);
+    platform_text(dialog_x+6.0f, dialog_y+4.0f,  "Controls:");
+
+    float y = dialog_y + 18.0f;
+    for(size_t i = 0; i < CONTROLS_LINE_COUNT; i++) {
+        if(controls_lines[i].text[0]) {
+            platform_text_color(controls_lines[i].color, BLACK);
+            platform_text(dialog_x+6.0f, y, controls_lines[i].text);
+        }
+        y += 12.0f;
+    }
+    platform_text_color(WHITE, BLACK);
 
     draw_rect(dialog_x, dialog_y + 428.0f, dialog_w, 1.0f, WHITE, z); 
-    DrawFormatString(dialog_x+6.0f, dialog_y+436.0f, "Stored profiles: %i/%i (max)", savedValueCount-2, ROW_CAPACITY);
+    platform_textf(dialog_x+6.0f, dialog_y+436.0f, "Stored profiles: %i/%i (max)", savedValueCount-2, PROFILE_CAPACITY);
 }
 
 void draw_header() {
-    DrawFormatString(0,0, "v%s", VERSION);
-    SetFontAutoCenter(1);
-    DrawString(350,0, "ezDNS");
-    SetFontAutoCenter(0);
-    DrawString(670,0, "github:tbwcjw/ps3ezDNS");
+    platform_textf(0,0, "v%s", VERSION);
+    platform_text_center(1);
+    platform_text(350,0, "ezDNS");
+    platform_text_center(0);
+    platform_textf(56,0, "Group: %.12s", activeLabel < 0 ? "All" : labelIndex[activeLabel].name);
+    platform_textf(232,0, "Sort: %s", sort_order_strings[sortOrder]);
+    platform_text(670,0, "github:tbwcjw/ps3ezDNS");
     draw_horizontal_line(14.0f, 1.0f);
 }
 
@@ -687,41 +1151,25 @@ void draw_footer() {
 
     
     if(modifiedValues.dnsFlag != currentValues.dnsFlag) { //asterisk to indicated modified, unsaved values
-        DrawFormatString(10,500, "*Mode: %s", DNS_FLAG_STRING(modifiedValues.dnsFlag));
+        platform_textf(10,500, "*Mode: %s", DNS_FLAG_STRING(modifiedValues.dnsFlag));
     } else {
-        DrawFormatString(10,500, "Mode: %s", DNS_FLAG_STRING(modifiedValues.dnsFlag));
+        platform_textf(10,500, "Mode: %s", DNS_FLAG_STRING(modifiedValues.dnsFlag));
     }
 
-    SetFontAutoCenter(1);
-    if(strcmp(modifiedValues.primaryDns, currentValues.primaryDns) != 0) {                     //if modified
-        if(strlen(modifiedValues.primaryDns) < 1) {                                 // if the dns is "auto"
-            DrawString(640,500, "*Primary: <auto>");                          // write <auto> w/ asterish
-        } else {
-            DrawFormatString(640,500, "*Primary: %s", modifiedValues.primaryDns);   // else the value w/asterisk
-        }
+    char addr_buf[ADDR_STRLEN];
+    platform_text_center(1);
+    if(!addr_equal(&modifiedValues.primaryDns, &currentValues.primaryDns)) {       //asterisk if modified
+        platform_textf(640,500, "*Primary: %s", addr_label(&modifiedValues.primaryDns, addr_buf, sizeof(addr_buf)));
     } else {
-        if(strlen(currentValues.primaryDns) < 1) {
-            DrawString(640,500, "Primary: <auto>");
-        } else {
-            DrawFormatString(640,500, "Primary: %s", currentValues.primaryDns);
-        }
+        platform_textf(640,500, "Primary: %s", addr_label(&currentValues.primaryDns, addr_buf, sizeof(addr_buf)));
     } 
-    SetFontAutoCenter(0);
+    platform_text_center(0);
     
     
-    if(strcmp(modifiedValues.secondaryDns, currentValues.secondaryDns) != 0) {
-        if(strlen(modifiedValues.secondaryDns) < 1) {
-            DrawString(640,500, "*Secondary: <auto>");
-        } else {
-            DrawFormatString(640,500, "*Secondary: %s", modifiedValues.secondaryDns);
-        }
-        
+    if(!addr_equal(&modifiedValues.secondaryDns, &currentValues.secondaryDns)) {
+        platform_textf(640,500, "*Secondary: %s", addr_label(&modifiedValues.secondaryDns, addr_buf, sizeof(addr_buf)));
     } else {
-        if(strlen(currentValues.secondaryDns) < 1) {
-            DrawString(640,500, "Secondary: <auto>");
-        } else {
-            DrawFormatString(640,500, "Secondary: %s", currentValues.secondaryDns);
-        }
+        platform_textf(640,500, "Secondary: %s", addr_label(&currentValues.secondaryDns, addr_buf, sizeof(addr_buf)));
     }
 }
 
@@ -730,438 +1178,1846 @@ void throw_error(int recoverable,
                     const char* l2, 
                     const char* l3) {
     error_recoverable = recoverable;
-    el1 = strdup(l1);
-    el2 = strdup(l2);
-    el3 = strdup(l3);
-    currentState = STATE_ERROR_DIALOG;
+    snprintf(el1, sizeof(el1), "%s", l1 ? l1 : "");
+    snprintf(el2, sizeof(el2), "%s", l2 ? l2 : "");
+    snprintf(el3, sizeof(el3), "%s", l3 ? l3 : "");
+    set_state(STATE_ERROR_DIALOG);
+    frame_dirty = 1; //new text even if an error was already showing
     netDebug("error (%s): %s: %s, %s", recoverable ? "recoverable" : "unrecoverable", el1, el2, el3);
 }
 
-int profiles_csv_exists() {
-    FILE *file = fopen(PROFILE_PATH, "r");
-    if (file) {
-        fclose(file);
-        return SUCCESS;
-    }
-    return FAILURE;
+//grow savedValueList geometrically so bulk adds don't realloc per row
+int reserve_saved_values(int needed) {
+    if(needed <= savedValueCapacity) return SUCCESS;
+    int capacity = savedValueCapacity ? savedValueCapacity : 8;
+    while(capacity < needed) capacity *= 2;
+    //realloc frees the old block on success, so each grown pointer is kept
+    //right away; the capacity only moves once all three arrays have room
+    Values *list = realloc(savedValueList, capacity * sizeof(Values));
+    if(!list) return FAILURE;
+    savedValueList = list;
+
+    int *index = realloc(nameIndex, capacity * sizeof(int));
+    if(!index) return FAILURE;
+    nameIndex = index;
+
+    index = realloc(sortIndex, capacity * sizeof(int));
+    if(!index) return FAILURE;
+    sortIndex = index;
+
+    savedValueCapacity = capacity;
+    return SUCCESS;
 }
 
-int load_profiles_csv() {
-    if (!profiles_csv_exists()) {
-        char *header[] = {"name","primary","secondary"};
-        if (csv_create(PROFILE_PATH, header, 3, ',') != 1)
-            return FAILURE;
-        return SUCCESS;
-    }
+//on exit: the profile list, its indices and the settings pool
+void free_saved_values() {
+    for(int i = 0; i < labelCount; i++) free(labelIndex[i].rows);
+    free(labelIndex);
+    labelIndex = NULL;
+    labelCount = labelCapacity = 0;
+    activeLabel = -1;
+
+    free(savedValueList);
+    free(nameIndex);
+    free(sortIndex);
+    savedValueList = NULL;
+    nameIndex = sortIndex = NULL;
+    savedValueCount = savedValueCapacity = sortIndexCount = 0;
+    tableViewStart = -1;
+    tableViewCount = 0;
+    nameset_free(&savedNames);
+
+    free(settingsPool);
+    settingsPool = NULL;
+    settingsPoolLen = settingsPoolCapacity = 0;
+
+    free(sortKeys);
+    sortKeys = NULL;
+    sortKeysCapacity = 0;
+}
 
-    CSVTable table = csv_read_all(PROFILE_PATH, ',');
-    if (table.count == 0) {
-        char *header[] = {"name","primary","secondary"};
-        csv_create(PROFILE_PATH, header, 3, ',');
-        return SUCCESS;
+//fill a profile record from text fields, empty address = <auto>
+int make_profile(Values *out, 
+                const char *name, 
+                int dnsFlag, 
+                const char *primary, 
+                const char *secondary,
+                const char *group,
+                const char *tags) {
+    memset(out, 0, sizeof(*out));
+    size_t name_len = strlen(name);
+    if(name_len >= sizeof(out->name)) return FAILURE;
+    memcpy(out->name, name, name_len + 1);
+    if(strlen(group) >= sizeof(out->group) || strlen(tags) >= sizeof(out->tags)) return FAILURE;
+    strcpy(out->group, group);
+    strcpy(out->tags, tags);
+    out->netSettings = 0;
+    out->dnsFlag = dnsFlag;
+    out->latencyMs = -1;
+    if(primary[0] && addr_parse(primary, strlen(primary), &out->primaryDns) == ADDR_NONE) return FAILURE;
+    if(secondary[0] && addr_parse(secondary, strlen(secondary), &out->secondaryDns) == ADDR_NONE) return FAILURE;
+    return SUCCESS;
+}
+
+//first slot in a name-sorted index list whose name is >= key (or > key when upper),
+//comparing only the first len chars when len > 0
+static int index_bound(const int *list, int count, const char *key, size_t len, int upper) {
+    int lo = 0, hi = count;
+    while(lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        const char *name = savedValueList[list[mid]].name;
+        int cmp = len ? strncasecmp(name, key, len) : strcasecmp(name, key);
+        if(cmp < 0 || (upper && cmp == 0)) lo = mid + 1;
+        else hi = mid;
     }
+    return lo;
+}
 
-    size_t oldCount = savedValueCount;
-    savedValueList = realloc(savedValueList,
-                             (savedValueCount + table.count - 1) * sizeof(Values));
+//binary insertion keeps an index list sorted without a full sort per add.
+//list must have room for count + 1. returns the new count
+static int index_list_insert(int *list, int count, int idx) {
+    int slot = index_bound(list, count, savedValueList[idx].name, 0, 0);
+    if(slot < count && list[slot] == idx) return count; //already listed, e.g. repeated tag
+    memmove(&list[slot + 1], &list[slot], (count - slot) * sizeof(int));
+    list[slot] = idx;
+    return count + 1;
+}
 
-    for (size_t i = 1; i < table.count; i++) {
-        CSVRow *row = &table.rows[i];
-        if (row->count < 3) continue;
-        savedValueList[oldCount].name = strdup(row->fields[0]);
-        savedValueList[oldCount].dnsFlag = DNS_FLAG_MANUAL;
-        savedValueList[oldCount].primaryDns = strdup(row->fields[1]);
-        savedValueList[oldCount].secondaryDns = strdup(row->fields[2]);
-        oldCount++;
+//renumber an index list after a compaction, dropping entries mapped to -1. returns the new count
+static int index_list_remap(int *list, int count, const int *remap) {
+    int out = 0;
+    for(int i = 0; i < count; i++) {
+        if(remap[list[i]] >= 0) list[out++] = remap[list[i]];
     }
+    return out;
+}
 
-    savedValueCount = oldCount;
-    csv_free_table(&table);
-    return SUCCESS;
+//name order with the row as tie break, the order index_bound searches
+static int name_cmp(int a, int b) {
+    int cmp = strcasecmp(savedValueList[a].name, savedValueList[b].name);
+    return cmp ? cmp : a - b;
 }
 
+static int name_cmp_qsort(const void *a, const void *b) {
+    return name_cmp(*(const int *)a, *(const int *)b);
+}
 
-void strtolower(const char *str, 
-                char *out, 
-                size_t out_size) {
-    size_t i;
-    for (i = 0; i < out_size - 1 && str[i]; i++) {
-        out[i] = tolower((unsigned char)str[i]);
+//list[0..sorted) is in cmp order, list[sorted..count) was appended by a bulk
+//add: sort just the appended rows and merge them in from the back, one pass
+//instead of a memmove per row
+static void index_list_merge(int *list, int sorted, int count,
+                             int (*cmp)(int, int), int (*qcmp)(const void *, const void *)) {
+    int added = count - sorted;
+    if(added <= 0) return;
+    int *tail = malloc(added * sizeof(int));
+    if(!tail) { //still correct, just not as cheap
+        qsort(list, count, sizeof(int), qcmp);
+        return;
+    }
+    memcpy(tail, list + sorted, added * sizeof(int));
+    qsort(tail, added, sizeof(int), qcmp);
+    int i = sorted - 1, j = added - 1, k = count - 1;
+    while(j >= 0) {
+        if(i >= 0 && cmp(list[i], tail[j]) > 0) list[k--] = list[i--];
+        else list[k--] = tail[j--];
     }
-    out[i] = '\0';
+    free(tail);
 }
 
-const char *validation_state_to_string(ValidationState state) {
-    if (state < 0 || state >= VALIDATION_STATE_COUNT)
-        return "Unknown validation state";
-    return validation_state_strings[state];
+static LabelIndex *get_label(const char *name) {
+    for(int i = 0; i < labelCount; i++) {
+        if(strcasecmp(labelIndex[i].name, name) == 0) return &labelIndex[i];
+    }
+    if(labelCount == labelCapacity) {
+        int capacity = labelCapacity ? labelCapacity * 2 : 8;
+        LabelIndex *labels = realloc(labelIndex, capacity * sizeof(LabelIndex));
+        if(!labels) return NULL;
+        labelIndex = labels;
+        labelCapacity = capacity;
+    }
+    LabelIndex *label = &labelIndex[labelCount++];
+    memset(label, 0, sizeof(*label));
+    snprintf(label->name, sizeof(label->name), "%s", name);
+    return label;
 }
 
-ValidationState validate_new_profile_form() {
-    if(savedValueCount-2 >= ROW_CAPACITY) return TOO_MANY_ROWS; //ignore 2; we have "Current" and "System default"
-    if(strlen(osk_name_buf) < 1) return NAME_LENGTH; // maxlen is handled by osk buffers
+static void label_add_row(const char *name, int idx) {
+    if(!name[0]) return;
+    LabelIndex *label = get_label(name);
+    if(!label) return;
+    if(label->count == label->capacity) {
+        int capacity = label->capacity ? label->capacity * 2 : 8;
+        int *rows = realloc(label->rows, capacity * sizeof(int));
+        if(!rows) return;
+        label->rows = rows;
+        label->capacity = capacity;
+    }
+    if(bulkStart < 0) label->count = index_list_insert(label->rows, label->count, idx);
+    else if(label->count == 0 || label->rows[label->count - 1] != idx) label->rows[label->count++] = idx;
+}
 
-    //unique check
-    for(int i = 0; i < savedValueCount; i++) {
-        char lower_osk_name_buf[sizeof(osk_name_buf)];
-        char lower_name[sizeof(osk_name_buf)];
+//list row idx under its group and each of its tags
+static void index_profile_labels(int idx) {
+    const Values *profile = &savedValueList[idx];
+    label_add_row(profile->group, idx);
+
+    const char *p = profile->tags;
+    while(*p) {
+        const char *end = strchr(p, TAG_SEPARATOR);
+        if(!end) end = p + strlen(p);
+        const char *last = end;
+        while(p < last && *p == ' ') p++;
+        while(last > p && last[-1] == ' ') last--;
+
+        char tag[PROFILE_LABEL_SIZE];
+        size_t len = last - p;
+        if(len >= sizeof(tag)) len = sizeof(tag) - 1;
+        memcpy(tag, p, len);
+        tag[len] = '\0';
+        label_add_row(tag, idx);
+
+        p = *end ? end + 1 : end;
+    }
+}
 
-        strtolower(osk_name_buf, lower_osk_name_buf, sizeof(lower_osk_name_buf));
-        strtolower(savedValueList[i].name, lower_name, sizeof(lower_name));
-        
-        if(strcmp(lower_osk_name_buf, lower_name) == 0) return NAME_UNIQUENESS;
+//attach extra registry keys to a profile, FAILURE if they don't parse
+int profile_set_settings(Values *profile, const char *settings) {
+    if(strlen(settings) >= PROFILE_SETTINGS_SIZE) return FAILURE;
+    int count = net_settings_each(settings, NULL, NULL);
+    if(count < 0 || count > NET_SETTINGS_MAX) return FAILURE;
+    if(!settings[0]) {
+        profile->netSettings = 0;
+        return SUCCESS;
     }
+    uint32_t off = intern_settings(settings);
+    if(!off) return FAILURE;
+    profile->netSettings = off;
+    return SUCCESS;
+}
 
-    for(int i = 0; osk_name_buf[i] != '\0'; i++) {
-        if(osk_name_buf[i] == ',') return NAME_COMMA;
+//the sortOrder part of profile_cmp, 0 when rows a and b tie on it
+static int metric_cmp(int a, int b) {
+    const Values *x = &savedValueList[a];
+    const Values *y = &savedValueList[b];
+    switch(sortOrder) {
+        case SORT_LAST_USED: //most recent first
+            if(x->lastUsed != y->lastUsed) return x->lastUsed > y->lastUsed ? -1 : 1;
+            break;
+        case SORT_USE_COUNT: //most used first
+            if(x->useCount != y->useCount) return x->useCount > y->useCount ? -1 : 1;
+            break;
+        case SORT_LATENCY: //fastest first, unmeasured (-1 -> UINT_MAX) last
+            if(x->latencyMs != y->latencyMs) return (unsigned)x->latencyMs < (unsigned)y->latencyMs ? -1 : 1;
+            break;
+        default:
+            break;
     }
+    return 0;
+}
 
-    if(strlen(osk_primary_buf) < 7) return PRIMARY_DNS_LENGTH;
-    if(is_valid_addr(osk_primary_buf) == FAILURE) return PRIMARY_DNS_ADDR_INVALID;
+//order of rows a and b under sortOrder; names are unique so this is total
+static int profile_cmp(int a, int b) {
+    int cmp = metric_cmp(a, b);
+    return cmp ? cmp : name_cmp(a, b);
+}
 
-    if(strlen(osk_secondary_buf) < 7) return SECONDARY_DNS_LENGTH;
-    if(is_valid_addr(osk_secondary_buf) == FAILURE) return SECONDARY_DNS_ADDR_INVALID;
+static int sort_bound(int idx) {
+    int lo = 0, hi = sortIndexCount;
+    while(lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if(profile_cmp(sortIndex[mid], idx) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
 
-    return VALID;
+static void sort_index_insert(int idx) {
+    if(sortOrder == SORT_FILE || idx < 2) return;
+    int pos = sort_bound(idx);
+    memmove(&sortIndex[pos + 1], &sortIndex[pos], (sortIndexCount - pos) * sizeof(int));
+    sortIndex[pos] = idx;
+    sortIndexCount++;
 }
 
-void add_saved_value(Values **list, int *count, Values newVal) {
-    *list = realloc(*list, (*count + 1) * sizeof(Values));
-    (*list)[*count].name = strdup(newVal.name);
-    (*list)[*count].dnsFlag = newVal.dnsFlag;
-    (*list)[*count].primaryDns = strdup(newVal.primaryDns);
-    (*list)[*count].secondaryDns = strdup(newVal.secondaryDns);
-    (*count)++;
+//call before changing a metric of idx: finds it under the old key
+static void sort_index_remove(int idx) {
+    if(sortOrder == SORT_FILE || idx < 2) return;
+    int pos = sort_bound(idx);
+    if(pos >= sortIndexCount || sortIndex[pos] != idx) return;
+    memmove(&sortIndex[pos], &sortIndex[pos + 1], (sortIndexCount - pos - 1) * sizeof(int));
+    sortIndexCount--;
 }
 
-int delete_profile() {
-    netDebug("%s", curPosValues.name);
+//FAILURE when there is no memory for the row, the list is left as it was
+int add_saved_value(Values **list, int *count, Values newVal) {
+    if(reserve_saved_values(*count + 1) != SUCCESS) return FAILURE;
+    //nameset_add also refuses a name it has, callers that care check uniqueness first
+    if(!nameset_add(&savedNames, newVal.name) && !nameset_contains(&savedNames, newVal.name)) return FAILURE;
+    (*list)[*count] = newVal;
+    if(bulkStart < 0) {
+        index_list_insert(nameIndex, *count, *count);
+        sort_index_insert(*count);
+    } else {
+        nameIndex[*count] = *count;
+    }
+    index_profile_labels(*count);
+    (*count)++;
+    return SUCCESS;
+}
 
-    //remove row from csv
-    if(csv_remove_row(PROFILE_PATH, 0, curPosValues.name, ',') != 1) {
-        return FAILURE;
+//drop the rows marked remap[i] == -1 from the list and every index. fills in remap
+static void compact_saved_values(int *remap) {
+    int kept = 0;
+    for(int i = 0; i < savedValueCount; i++) {
+        if(remap[i] < 0) {
+            nameset_remove(&savedNames, savedValueList[i].name);
+            continue;
+        }
+        remap[i] = kept;
+        if(kept != i) savedValueList[kept] = savedValueList[i];
+        kept++;
     }
-    netDebug("Removed row from csv");
+    index_list_remap(nameIndex, savedValueCount, remap);
+    sortIndexCount = index_list_remap(sortIndex, sortIndexCount, remap);
+    for(int l = 0; l < labelCount; l++) {
+        labelIndex[l].count = index_list_remap(labelIndex[l].rows, labelIndex[l].count, remap);
+    }
+    savedValueCount = kept;
+}
 
-    //search for and remove in savedValueList
-    for(int i=0; i < savedValueCount; i++) {
-        if(savedValueList[i].name && strcmp(savedValueList[i].name, curPosValues.name) == 0) { //found
-            //shift left
-            for(int j = i; j < savedValueCount; j++) {
-                savedValueList[j] = savedValueList[j+1];
-            }
-            savedValueCount--;
-            netDebug("Removed row from savedValueList");
-            return SUCCESS;
+//recompute the rows matching the group and search prefix: the active index
+//list is already name-sorted, so the prefix is two binary searches into it
+void refresh_view() {
+    if(search_len == 0 && activeLabel < 0) {
+        tableViewStart = -1;
+        tableViewCount = 0;
+    } else {
+        int count = activeLabel < 0 ? savedValueCount : labelIndex[activeLabel].count;
+        int lo = 0, hi = count;
+        if(search_len > 0) {
+            lo = index_bound(view_list(), count, search_buf, search_len, 0);
+            hi = index_bound(view_list(), count, search_buf, search_len, 1);
         }
+        tableViewStart = lo;
+        tableViewCount = hi - lo;
     }
-    return FAILURE;
+    if(cur_pos >= view_count()) cur_pos = 0;
+    if(view_count() > 0) curPosValues = savedValueList[view_index(cur_pos)];
 }
 
-void reset_new_profile_form() {
-    memset(osk_name_buf, 0, sizeof(osk_name_buf));
-    memset(osk_primary_buf, 0, sizeof(osk_primary_buf));
-    memset(osk_secondary_buf, 0, sizeof(osk_secondary_buf));
+//step to the next (dir 1) or previous (dir -1) non-empty group/tag, wrapping through "all"
+void cycle_label(int dir) {
+    int label = activeLabel;
+    for(int i = 0; i <= labelCount; i++) {
+        label += dir;
+        if(label >= labelCount) label = -1;
+        if(label < -1) label = labelCount - 1;
+        if(label < 0 || labelIndex[label].count > 0) break;
+    }
+    activeLabel = label;
+    cur_pos = 0;
+    refresh_view();
 }
-int main(int argc, char **argv) {
-    //initialize tiny3d
-    tiny3d_Init(1024*1024);
-    tiny3d_Project2D();
-    load_texture();
-
-    //set up font
-    SetCurrentFont(0);
-    SetFontSize(8,13);
-    SetFontColor(WHITE, BLACK);
-    SetFontAutoCenter(0);
-    SetFontZ(65535.0f);
-
-    //initialize pad
-    ioPadInit(7);
-    padInfo padinfo;
-	padData paddata;
-    memset(&paddata, 0, sizeof(paddata));
-    
-    //initialize network/debugging
-    netInitialize();
-    netDebugInit();
-    netDebug("Hello!");
 
-    //load registry
-    xreg_registry_t *reg = xreg_load(XREG_PATH);
-    if (!reg) {
-        netDebug("Failed to load xRegistry file");
-        throw_error(ERR_UNRECOVERABLE, "Failed to load the xRegistry file.", "Ensure it exists at:", XREG_PATH);
+//where the view shows savedValueList[idx], or -1 if it's filtered out
+int view_position(int idx) {
+    if(tableViewStart >= 0) {
+        const int *run = view_list() + tableViewStart;
+        int pos = index_bound(run, tableViewCount, savedValueList[idx].name, 0, 0);
+        return pos < tableViewCount && run[pos] == idx ? pos : -1;
     }
+    if(sortOrder == SORT_FILE || idx < 2) return idx;
+    int pos = sort_bound(idx);
+    return pos < sortIndexCount && sortIndex[pos] == idx ? pos + 2 : -1;
+}
 
-    if(get_value_int(reg, DNS_FLAG_KEY, &currentValues.dnsFlag) != SUCCESS) {
-        netDebug("Failed to read DNS flag");
-        throw_error(ERR_UNRECOVERABLE, "Failed to read DNS flag", "This is most probably a bug.", "Report it on Github.");
-    } else {
-        netDebug("%d", currentValues.dnsFlag);
+//put the cursor back on a row after the view was reordered
+void select_profile(int idx) {
+    int pos = idx >= 0 && idx < savedValueCount ? view_position(idx) : -1;
+    if(pos >= 0) cur_pos = pos;
+    else if(cur_pos >= view_count()) cur_pos = view_count() > 0 ? view_count() - 1 : 0;
+    if(view_count() > 0) curPosValues = savedValueList[view_index(cur_pos)];
+}
+
+static int sort_cmp_qsort(const void *a, const void *b) {
+    return profile_cmp(*(const int *)a, *(const int *)b);
+}
+
+//metric_cmp as an unsigned key, smaller sorts first
+static uint64_t metric_key(int idx) {
+    const Values *x = &savedValueList[idx];
+    switch(sortOrder) {
+        case SORT_LAST_USED: //most recent first
+            return ~((uint64_t)x->lastUsed ^ (1ULL << 63));
+        case SORT_USE_COUNT: //most used first
+            return ~((uint32_t)x->useCount ^ (1U << 31)) & 0xFFFFFFFFu;
+        case SORT_LATENCY: //unmeasured (-1 -> UINT_MAX) last
+            return (uint32_t)x->latencyMs;
+        default:
+            return 0;
     }
+}
 
-    if (get_value_string(reg, DNS_PRIMARY_KEY, &currentValues.primaryDns) != SUCCESS) {
-        throw_error(ERR_RECOVERABLE, "Failed to read primary DNS", "This is most probably a bug.", "Report it on Github.");
-    } else {
-        netDebug(currentValues.primaryDns);
+//stable radix sort of list on metric_key, a byte per pass. keys are taken
+//relative to the smallest, so only the bytes the keys actually span get a
+//pass: one for use counts, none at all when every key ties
+static int metric_sort(int *list, int count) {
+    if(count > sortKeysCapacity) {
+        SortKey *keys = realloc(sortKeys, count * 2 * sizeof(SortKey));
+        if(!keys) return FAILURE;
+        sortKeys = keys;
+        sortKeysCapacity = count;
+    }
+    SortKey *from = sortKeys, *to = sortKeys + count;
+    uint64_t lo = UINT64_MAX, hi = 0;
+    for(int i = 0; i < count; i++) {
+        uint64_t key = metric_key(list[i]);
+        from[i] = (SortKey){key, list[i]};
+        if(key < lo) lo = key;
+        if(key > hi) hi = key;
+    }
+    for(int shift = 0; shift < 64 && count > 0 && ((hi - lo) >> shift) != 0; shift += 8) {
+        int offsets[256] = {0};
+        for(int i = 0; i < count; i++) offsets[((from[i].key - lo) >> shift) & 0xFF]++;
+        for(int d = 0, pos = 0; d < 256; d++) {
+            int n = offsets[d];
+            offsets[d] = pos;
+            pos += n;
+        }
+        for(int i = 0; i < count; i++) to[offsets[((from[i].key - lo) >> shift) & 0xFF]++] = from[i];
+        SortKey *swap = from;
+        from = to;
+        to = swap;
     }
+    for(int i = 0; i < count; i++) list[i] = from[i].idx;
+    return SUCCESS;
+}
 
-    if (get_value_string(reg, DNS_SECONDARY_KEY, &currentValues.secondaryDns) != SUCCESS) {
-        throw_error(ERR_RECOVERABLE, "Failed to read secondary DNS", "This is most probably a bug.", "Report it on Github.");
-    } else {
-        netDebug(currentValues.secondaryDns);
+//full sort only when the order itself changes; metric updates re-insert one row
+void set_sort_order(SortOrder order) {
+    int selected = view_count() > 0 ? view_index(cur_pos) : -1;
+    sortOrder = order;
+    sortIndexCount = 0;
+    if(sortOrder != SORT_FILE) {
+        //nameIndex is already in name order, the tie break of every order, so
+        //a stable sort on the metric alone gives profile_cmp order
+        for(int i = 0; i < savedValueCount; i++) {
+            if(nameIndex[i] >= 2) sortIndex[sortIndexCount++] = nameIndex[i];
+        }
+        if(sortOrder != SORT_NAME && metric_sort(sortIndex, sortIndexCount) != SUCCESS) {
+            qsort(sortIndex, sortIndexCount, sizeof(int), sort_cmp_qsort);
+        }
     }
+    refresh_view();
+    select_profile(selected);
+}
 
-    //set default from system
-    modifiedValues.dnsFlag = currentValues.dnsFlag;
-    modifiedValues.primaryDns = currentValues.primaryDns;
-    modifiedValues.secondaryDns = currentValues.secondaryDns;
+//loading, reloading and importing add rows by the thousand
+void begin_bulk_add() {
+    bulkStart = savedValueCount;
+    for(int i = 0; i < labelCount; i++) labelIndex[i].sorted = labelIndex[i].count;
+}
 
-    Values current = {"Current", currentValues.dnsFlag, currentValues.primaryDns, currentValues.secondaryDns};
-    add_saved_value(&savedValueList, &savedValueCount, current);
+void end_bulk_add() {
+    if(bulkStart < 0) return;
+    int start = bulkStart;
+    bulkStart = -1;
+    index_list_merge(nameIndex, start, savedValueCount, name_cmp, name_cmp_qsort);
+    for(int i = 0; i < labelCount; i++) {
+        index_list_merge(labelIndex[i].rows, labelIndex[i].sorted, labelIndex[i].count, name_cmp, name_cmp_qsort);
+    }
+    if(sortOrder != SORT_FILE) {
+        int sorted = sortIndexCount;
+        for(int i = start > 2 ? start : 2; i < savedValueCount; i++) sortIndex[sortIndexCount++] = i;
+        index_list_merge(sortIndex, sorted, sortIndexCount, profile_cmp, sort_cmp_qsort);
+    }
+}
 
-    Values sys_default = {"System Default", DNS_FLAG_AUTOMATIC, "", ""};
-    add_saved_value(&savedValueList, &savedValueCount, sys_default);
+//a profile was applied: bump its metrics and move just that row
+//runs on the persister thread, entry and its name are one block
+static void append_use_stats(void *ctx) {
+    stats_entry_t *entry = ctx;
+    if(stats_append(STATS_PATH, entry) != 1) netDebug("Failed to record use of %s", entry->name);
+    free(entry);
+}
 
-    if(!profiles_csv_exists()) { //csv file doesnt exist assume first run
-        currentState = STATE_FIRST_RUN_DIALOG;
+void record_profile_use(int idx) {
+    int selected = view_count() > 0 ? view_index(cur_pos) : -1;
+    sort_index_remove(idx);
+    savedValueList[idx].lastUsed = time(NULL);
+    savedValueList[idx].useCount++;
+    sort_index_insert(idx);
+    select_profile(selected);
+
+    //the hdd write goes to the persister, the table already shows the new counts
+    size_t name_len = strlen(savedValueList[idx].name) + 1;
+    stats_entry_t *entry = malloc(sizeof(*entry) + name_len);
+    if(!entry) return;
+    memcpy(entry + 1, savedValueList[idx].name, name_len);
+    entry->name = (const char *)(entry + 1);
+    entry->last_used = savedValueList[idx].lastUsed;
+    entry->use_count = savedValueList[idx].useCount;
+    if(persist_run(append_use_stats, entry) != 1) {
+        netDebug("Failed to queue use of %s", entry->name);
+        free(entry);
     }
-    //create+load/load profiles csv
-    if(load_profiles_csv() != SUCCESS) {
-        throw_error(ERR_UNRECOVERABLE, "Failed to load data.", "The file may not exist or has ", "malformed data; check for empty lines.");
+}
+
+void set_search_prefix(const char *prefix) {
+    snprintf(search_buf, sizeof(search_buf), "%s", prefix);
+    search_len = strlen(search_buf);
+    cur_pos = 0;
+    refresh_view();
+}
+
+int profiles_csv_exists() {
+    FILE *file = fopen(PROFILE_PATH, "r");
+    if (file) {
+        fclose(file);
+        return SUCCESS;
     }
+    return FAILURE;
+}
 
-    while(!exit_requested) {
-        //clear screen
-        tiny3d_Clear(0xff000000, TINY3D_CLEAR_ALL);
-        
-        //handle pad input
-        ioPadGetInfo(&padinfo);
-        if (padinfo.status[0] && ioPadGetData(0, &paddata) == 0) {
-            //save dialog entry: exit requested, check for changes, run save dialog if required.
-            if (PRESSED_NOW(BTN_SELECT) && currentState != STATE_SAVE_DIALOG) {
-                if(currentValues.dnsFlag != modifiedValues.dnsFlag) { //changes have been made, confirm exit. all other changes are made at time user selects from table
-                    currentState = STATE_SAVE_DIALOG;
-                } else {
-                    exit_requested = 1;     //no changes have been made, exit.
-                }
-            }
-            //11-10-25: fixed a bug where circle on save_dialog would open the deletion_confirmation dialog
-            //save dialog: X button saves and restarts
-            else if (PRESSED_NOW(BTN_CROSS) && currentState == STATE_SAVE_DIALOG) {
-                currentState = STATE_RESTART_DIALOG;
-                restart_countdown = 3;
-                time(&last_update);
-            }
-            //save dialog: Square exits without saving.
-            else if (PRESSED_NOW(BTN_SQUARE) && currentState == STATE_SAVE_DIALOG) {
-                exit_requested = 1;
-            }
+static char *profile_header[] = {"name","primary","secondary","group","tags","settings"};
+#define PROFILE_HEADER_COUNT (sizeof(profile_header) / sizeof(profile_header[0]))
 
-            //exit dialog: circle close dialog (cancel)
-            else if (PRESSED_NOW(BTN_CIRCLE) && currentState == STATE_SAVE_DIALOG) {
-                currentState = STATE_NO_DIALOG;
-            }
+//borrowed fields of the row being parsed, valid until the row callback returns
+#define PROFILE_FIELD_COUNT 6
+typedef struct {
+    const char *fields[PROFILE_FIELD_COUNT];
+} ProfileRow;
 
-            //confirmation dialog: open confirmation dialog from table
-            else if (PRESSED_NOW(BTN_CROSS) && currentState == STATE_NO_DIALOG) {
-                
-                //11-10-25: disallow setting of "current" profile.
-                if(cur_pos != 0) {
-                    currentState = STATE_CONFIRMATION_DIALOG;
-                    modifiedValues.dnsFlag = curPosValues.dnsFlag;
-                    modifiedValues.primaryDns = curPosValues.primaryDns;
-                    modifiedValues.secondaryDns = curPosValues.secondaryDns;
-                }
-            } else if (PRESSED_NOW(BTN_CROSS) && currentState == STATE_CONFIRMATION_DIALOG) { //save confirmed, restart
-                currentState = STATE_RESTART_DIALOG;
-                restart_countdown = 3;
-                time(&last_update);
-            }else if (PRESSED_NOW(BTN_CIRCLE) && currentState == STATE_CONFIRMATION_DIALOG) { //discard changes and resume
-                currentState = STATE_NO_DIALOG;
-
-                modifiedValues.dnsFlag = currentValues.dnsFlag;
-                modifiedValues.primaryDns = currentValues.primaryDns;
-                modifiedValues.secondaryDns = currentValues.secondaryDns;
-            }
+static int collect_profile_field(const char *field, size_t len, size_t col, void *ctx) {
+    ProfileRow *row = ctx;
+    if(col < PROFILE_FIELD_COUNT) row->fields[col] = field;
+    return 1;
+}
 
-            //deletion confirumation dialog: open from table, ignore first element
-            else if(PRESSED_NOW(BTN_CIRCLE) && currentState == STATE_NO_DIALOG) { 
-                if(cur_pos > 1) { // skip two
-                    currentState = STATE_DELETION_CONFIRMATION_DIALOG; //open dialog
-                }                
-            } else if(PRESSED_NOW(BTN_CIRCLE) && currentState == STATE_DELETION_CONFIRMATION_DIALOG) { //cancel
-                currentState = STATE_NO_DIALOG;
-            } else if(PRESSED_NOW(BTN_CROSS) && currentState == STATE_DELETION_CONFIRMATION_DIALOG) { //confirm
-                if(delete_profile() != SUCCESS) {
-                    throw_error(ERR_RECOVERABLE, "Failed to delete profile", "Perhaps the file is locked?", "Try again later");
-                }
-                netDebug("cur pos %i", cur_pos);
-                //11-10-25: instead of moving cursor up one, reset cursor to 0.
-                cur_pos = 0;
-                currentValues = savedValueList[0];
-                currentState = STATE_NO_DIALOG;
-            }
+//queue a profile row for the persister, addresses in canonical text form
+static int queue_profile_add(const Values *profile) {
+    char primary[ADDR_STRLEN];
+    char secondary[ADDR_STRLEN];
+    addr_format(&profile->primaryDns, primary, sizeof(primary));
+    addr_format(&profile->secondaryDns, secondary, sizeof(secondary));
+    char *fields[] = {(char *)profile->name, primary, secondary, (char *)profile->group, (char *)profile->tags, (char *)profile_settings(profile)};
+    return persist_add(fields, PROFILE_FIELD_COUNT);
+}
 
-            //new profile dialog: open with start
-            if(PRESSED_NOW(BTN_START) && currentState == STATE_NO_DIALOG) {
-                currentState = STATE_NEW_PROFILE_DIALOG;
-            } else if(PRESSED_NOW(BTN_CIRCLE) && currentState == STATE_NEW_PROFILE_DIALOG) { //close dialog
-                //discard changes
-                reset_new_profile_form();
-                //close dialog
-                cur_pos_new_profile_dialog = 0;
-                currentState = STATE_NO_DIALOG;
-            } else if(PRESSED_NOW(BTN_CROSS) && currentState == STATE_NEW_PROFILE_DIALOG) { //edit cur pos item value
-                if(cur_pos_new_profile_dialog == 0) { //name
-                    get_osk_string("Name", osk_name_buf, sizeof(osk_name_buf));
-                }
-                if(cur_pos_new_profile_dialog == 1) { //primary dns
-                    get_osk_string("Primary DNS", osk_primary_buf, sizeof(osk_primary_buf));
-                }
-                if(cur_pos_new_profile_dialog == 2) { //secondary dns
-                    get_osk_string("Secondary DNS", osk_secondary_buf, sizeof(osk_secondary_buf));
-                }
-                
-            } else if(PRESSED_NOW(BTN_SQUARE) && currentState == STATE_NEW_PROFILE_DIALOG) { //save values
-                //validate form
-                ValidationState valid = validate_new_profile_form();
-                if (valid == VALID) {
-                    //save fields in savedValueList & to file.
-                    Values newProfile = {osk_name_buf, DNS_FLAG_MANUAL, osk_primary_buf, osk_secondary_buf};
-                    add_saved_value(&savedValueList, &savedValueCount, newProfile);
-                    char *fields[] = {osk_name_buf, osk_primary_buf, osk_secondary_buf};
-                    if(csv_append_row(PROFILE_PATH, fields, 3, ',') == 0) {
-                        throw_error(ERR_RECOVERABLE, "Failed to save to file.", "This is most probably a bug.", "Report it on Github.");
-                    }
-                    //reset form and exit
-                    reset_new_profile_form();
-                    currentState = STATE_NO_DIALOG;
-                } else {
-                    throw_error(ERR_RECOVERABLE, "Invalid values in form.", validation_state_to_string(valid), "Please try again");
-                }
-            //up/down movement in form
-            } else if(PRESSED_NOW(BTN_DOWN) && currentState == STATE_NEW_PROFILE_DIALOG) { //move cur pos down
-                cur_pos_new_profile_dialog++;
-                if(cur_pos_new_profile_dialog > 2 || cur_pos_new_profile_dialog < 0) cur_pos_new_profile_dialog = 0;
-            } else if(PRESSED_NOW(BTN_UP) && currentState == STATE_NEW_PROFILE_DIALOG) { //move cur pos up
-                cur_pos_new_profile_dialog--;
-                if(cur_pos_new_profile_dialog > 2 || cur_pos_new_profile_dialog < 0) cur_pos_new_profile_dialog = 2;
-            }
+//group, tags and settings are optional trailing columns, files from older versions only have three
+static const char *profile_field(const ProfileRow *row, size_t field_count, size_t col) {
+    return col < field_count ? row->fields[col] : "";
+}
 
-            //error dialog: recoverable
-            else if (PRESSED_NOW(BTN_SQUARE) && currentState == STATE_ERROR_DIALOG && error_recoverable == 1) {
-                error_dialog_buzzer = 0; //reset buzzer flag for next error
-                currentState = STATE_NO_DIALOG;
-            } else if (PRESSED_NOW(BTN_SELECT) && currentState == STATE_ERROR_DIALOG && error_recoverable != 1) { //not recoverable
-                error_dialog_buzzer = 0;
-                currentState = STATE_NO_DIALOG; //these won't do anything, but for continuity sake we'll put them here.
-                break;
-            }
+static int profile_from_row(Values *out, const ProfileRow *row, size_t field_count) {
+    if(make_profile(out, row->fields[0], DNS_FLAG_MANUAL, row->fields[1], row->fields[2],
+                    profile_field(row, field_count, 3), profile_field(row, field_count, 4)) != SUCCESS) return FAILURE;
+    return profile_set_settings(out, profile_field(row, field_count, 5));
+}
 
-            //move cursor in table: move up
-            else if (PRESSED_NOW(BTN_DOWN) && currentState == STATE_NO_DIALOG) {
-                cur_pos++;
-                
-                if (cur_pos >= savedValueCount) cur_pos = 0;
-                netDebug("Current pos: %i", cur_pos);
-                curPosValues = savedValueList[cur_pos]; //set active item by cursor
-            }
+static int load_profile_row(size_t index, size_t field_count, void *ctx) {
+    ProfileRow *row = ctx;
+    if(index == 0 || field_count < 3) return 1; //header or malformed row
+    Values profile;
+    if(profile_from_row(&profile, row, field_count) != SUCCESS) {
+        netDebug("Skipping malformed profile row %i", (int)index);
+        return 1;
+    }
+    if(add_saved_value(&savedValueList, &savedValueCount, profile) != SUCCESS) {
+        netDebug("Out of memory at profile row %i", (int)index);
+        return 0;
+    }
+    return 1;
+}
 
-            //move cursor in table: move down
-            else if (PRESSED_NOW(BTN_UP) && currentState == STATE_NO_DIALOG) {
-                cur_pos--;
-                
-                if (cur_pos < 0) cur_pos = savedValueCount - 1;
-                netDebug("Current pos: %i", cur_pos);
-                curPosValues = savedValueList[cur_pos]; //set active item by cursor
-            }
+int load_profiles_csv() {
+    if (!profiles_csv_exists()) {
+        if (csv_create(PROFILE_PATH, profile_header, PROFILE_HEADER_COUNT, ',') != 1)
+            return FAILURE;
+        return SUCCESS;
+    }
 
-            //change dns mode
-            else if (PRESSED_NOW(BTN_TRIANGLE) && currentState == STATE_NO_DIALOG) {
-                modifiedValues.dnsFlag = !modifiedValues.dnsFlag;
-            }
+    ProfileRow row = {{NULL}};
+    begin_bulk_add();
+    int ok = csv_parse_stream(PROFILE_PATH, ',', collect_profile_field, load_profile_row, &row);
+    end_bulk_add();
+    return ok == 1 ? SUCCESS : FAILURE;
+}
 
-            //firsty run dialog: square to close
-            else if (PRESSED_NOW(BTN_SQUARE) && currentState == STATE_FIRST_RUN_DIALOG) {
-                currentState = STATE_NO_DIALOG;
-            }
-            
-            //reset pad events
-            lastPad = (PadButtons){
-                .BTN_CROSS   = paddata.BTN_CROSS,
-                .BTN_CIRCLE  = paddata.BTN_CIRCLE,
-                .BTN_SQUARE  = paddata.BTN_SQUARE,
-                .BTN_TRIANGLE= paddata.BTN_TRIANGLE,
-                .BTN_UP      = paddata.BTN_UP,
-                .BTN_DOWN    = paddata.BTN_DOWN,
-                .BTN_LEFT    = paddata.BTN_LEFT,
-                .BTN_RIGHT   = paddata.BTN_RIGHT,
-                .BTN_SELECT  = paddata.BTN_SELECT,
-                .BTN_START   = paddata.BTN_START
-            };
+const char *validation_state_to_string(ValidationState state) {
+    if (state < 0 || state >= VALIDATION_STATE_COUNT)
+        return "Unknown validation state";
+    return validation_state_strings[state];
+}
+
+//the registry keeps dns servers in fixed size string values (16 bytes on
+//retail firmware), an address whose text is longer could never be applied
+static int dns_fits_registry(const char *key_name, const addr_t *addr) {
+    char text[ADDR_STRLEN];
+    long capacity = xreg_text_capacity(registry, key_name);
+    return capacity < 0 || (long)addr_format(addr, text, sizeof(text)) <= capacity;
+}
+
+ValidationState validate_new_profile_form() {
+    if(savedValueCount-2 >= PROFILE_CAPACITY) return TOO_MANY_ROWS; //ignore 2; we have "Current" and "System default"
+    if(strlen(osk_name_buf) < 1) return NAME_LENGTH; // maxlen is handled by osk buffers
+
+    //unique check, case insensitive
+    if(nameset_contains(&savedNames, osk_name_buf)) return NAME_UNIQUENESS;
+
+    for(int i = 0; osk_name_buf[i] != '\0'; i++) {
+        if(osk_name_buf[i] == ',') return NAME_COMMA;
+    }
+
+    if(strlen(osk_primary_buf) < ADDR_MIN_STRLEN) return PRIMARY_DNS_LENGTH;
+    if(strlen(osk_secondary_buf) < ADDR_MIN_STRLEN) return SECONDARY_DNS_LENGTH;
+
+    const char *addrs[] = {osk_primary_buf, osk_secondary_buf};
+    addr_t parsed[2];
+    if(addr_parse_many(addrs, 2, parsed) != 2) {
+        return parsed[0].family == ADDR_NONE ? PRIMARY_DNS_ADDR_INVALID : SECONDARY_DNS_ADDR_INVALID;
+    }
+    if(!dns_fits_registry(DNS_PRIMARY_KEY, &parsed[0])) return PRIMARY_DNS_TOO_LONG;
+    if(!dns_fits_registry(DNS_SECONDARY_KEY, &parsed[1])) return SECONDARY_DNS_TOO_LONG;
+
+    return VALID;
+}
+
+int delete_profile() {
+    netDebug("%s", curPosValues.name);
+
+    //remove row from csv, written in the background
+    if(persist_remove(curPosValues.name) != 1) {
+        return FAILURE;
+    }
+    netDebug("Queued csv row removal");
+
+    //search for and remove in savedValueList
+    for(int i=0; i < savedValueCount; i++) {
+        if(strcmp(savedValueList[i].name, curPosValues.name) == 0) { //found
+            int *remap = calloc(savedValueCount, sizeof(int));
+            if(!remap) return FAILURE;
+            remap[i] = -1;
+            compact_saved_values(remap);
+            free(remap);
+            netDebug("Removed row from savedValueList");
+            return SUCCESS;
         }
+    }
+    return FAILURE;
+}
 
-        //draw always visible elements
-        draw_header();
-        draw_profile_table();
-        draw_controls_box();
-        draw_footer();
+void reset_new_profile_form() {
+    memset(osk_name_buf, 0, sizeof(osk_name_buf));
+    memset(osk_primary_buf, 0, sizeof(osk_primary_buf));
+    memset(osk_secondary_buf, 0, sizeof(osk_secondary_buf));
+    memset(osk_group_buf, 0, sizeof(osk_group_buf));
+    memset(osk_tags_buf, 0, sizeof(osk_tags_buf));
+    memset(osk_settings_buf, 0, sizeof(osk_settings_buf));
+}
+//bulk import: first file found wins. usb first so a stick overrides a stale hdd copy
+static const char *import_paths[] = {
+    PLATFORM_ROOT "/dev_usb000/" IMPORT_FILENAME,
+    PLATFORM_ROOT "/dev_usb001/" IMPORT_FILENAME,
+    PLATFORM_ROOT "/dev_hdd0/tmp/" IMPORT_FILENAME
+};
+#define IMPORT_PATH_COUNT (sizeof(import_paths) / sizeof(import_paths[0]))
+
+static const char *import_path = NULL;
+static int import_added = 0;
+static int import_skipped = 0;
+static int import_out_of_memory = 0; //stopped at a row there was no room for
+
+//copy field without surrounding whitespace, fails if it doesn't fit
+static int copy_trimmed(char *out, size_t out_size, const char *field) {
+    const char *end = field + strlen(field);
+    while(*field == ' ' || *field == '\t') field++;
+    while(end > field && (end[-1] == ' ' || end[-1] == '\t')) end--;
+    size_t len = end - field;
+    if(len >= out_size) return FAILURE;
+    memcpy(out, field, len);
+    out[len] = '\0';
+    return SUCCESS;
+}
 
-        // save to registry and restart system.
-        if (currentState == STATE_RESTART_DIALOG) {
-            time_t current_time;
-            time(&current_time);
-            
-            if(save_modified_values(reg) != SUCCESS) { //save to xregistry
-                netDebug("Failed to save modified values");
+//validate one "name,primary,secondary[,group,tags,settings]" row and queue it for the persister
+static int import_profile_row(size_t index, size_t field_count, void *ctx) {
+    ProfileRow *row = ctx;
+    if(field_count == 0) return 1; //blank line
+
+    char name[sizeof(osk_name_buf)];
+    char primary[ADDR_STRLEN];
+    char secondary[ADDR_STRLEN];
+    char group[PROFILE_LABEL_SIZE];
+    char tags[PROFILE_TAGS_SIZE];
+    char settings[PROFILE_SETTINGS_SIZE];
+    if(field_count < 3 ||
+       copy_trimmed(name, sizeof(name), row->fields[0]) != SUCCESS ||
+       copy_trimmed(primary, sizeof(primary), row->fields[1]) != SUCCESS ||
+       copy_trimmed(secondary, sizeof(secondary), row->fields[2]) != SUCCESS ||
+       copy_trimmed(group, sizeof(group), profile_field(row, field_count, 3)) != SUCCESS ||
+       copy_trimmed(tags, sizeof(tags), profile_field(row, field_count, 4)) != SUCCESS ||
+       copy_trimmed(settings, sizeof(settings), profile_field(row, field_count, 5)) != SUCCESS) {
+        import_skipped++;
+        return 1;
+    }
+
+    if(index == 0 && strcasecmp(name, "name") == 0 && strcasecmp(primary, "primary") == 0) return 1; //header
+
+    if(name[0] == '\0' || strchr(name, ',') || strchr(name, '"')) { import_skipped++; return 1; }
+    if(nameset_contains(&savedNames, name)) { import_skipped++; return 1; }
+    if(!primary[0] || !secondary[0]) { import_skipped++; return 1; } //both addresses required
+
+    if(savedValueCount-2 >= PROFILE_CAPACITY) { import_skipped++; return 1; }
+
+    Values profile; //parses and validates the addresses
+    if(make_profile(&profile, name, DNS_FLAG_MANUAL, primary, secondary, group, tags) != SUCCESS ||
+       profile_set_settings(&profile, settings) != SUCCESS) { import_skipped++; return 1; }
+    if(!dns_fits_registry(DNS_PRIMARY_KEY, &profile.primaryDns) ||
+       !dns_fits_registry(DNS_SECONDARY_KEY, &profile.secondaryDns)) { import_skipped++; return 1; } //v6 on a 16 byte slot
+    if(add_saved_value(&savedValueList, &savedValueCount, profile) != SUCCESS) {
+        import_out_of_memory = 1;
+        return 0;
+    }
+    if(queue_profile_add(&profile) != 1) import_skipped++;
+    else import_added++;
+    return 1;
+}
+
+//stream the import file; the persister coalesces the accepted rows into one append
+int import_profiles() {
+    import_path = NULL;
+    import_added = 0;
+    import_skipped = 0;
+    import_out_of_memory = 0;
+
+    for(size_t i = 0; i < IMPORT_PATH_COUNT && !import_path; i++) {
+        FILE *fp = fopen(import_paths[i], "r");
+        if(fp) {
+            fclose(fp);
+            import_path = import_paths[i];
+        }
+    }
+    if(!import_path) return FAILURE;
+
+    ProfileRow row = {{NULL}};
+    begin_bulk_add();
+    int ok = csv_parse_stream(import_path, ',', collect_profile_field, import_profile_row, &row);
+    end_bulk_add();
+    refresh_view(); //rows added before a failure stay
+    if(ok != 1) return FAILURE;
+    netDebug("Import from %s: %i added, %i skipped", import_path, import_added, import_skipped);
+    return SUCCESS;
+}
+
+void draw_import_dialog() {
+    float z = 65535.0f;
+
+    float dialog_w = 325.0f;
+    float dialog_h = 90.0f;
+    float dialog_x = (848.0f - dialog_w) / 2.0f;
+    float dialog_y = (512.0f - dialog_h) / 2.0f;
+    platform_text_center(1);
+
+    draw_rect(dialog_x, dialog_y, dialog_w, dialog_h, WHITE, z); 
+    draw_rect(dialog_x+2.0f, dialog_y+2.0f, dialog_w-4.0f, dialog_h-4.0f, BLACK, z); 
+
+    platform_text(dialog_x+16.0f, dialog_y+4.0f, "Import complete");
+    draw_rect(dialog_x, dialog_y+18.0f, dialog_w, 1.0f, WHITE, z); 
+
+    platform_textf(dialog_x+40.0f, dialog_y+23.0f, "From: %s", import_path);
+    platform_textf(dialog_x+40.0f, dialog_y+37.0f, "Imported %i profiles.", import_added);
+    platform_textf(dialog_x+40.0f, dialog_y+51.0f, "Skipped %i (invalid/duplicate/full).", import_skipped);
+
+    draw_rect(dialog_x, dialog_y+68.0f, dialog_w, 1.0f, WHITE, z); 
+
+    platform_text_color(SQUARE, BLACK);
+    platform_text(dialog_x+40.0f, dialog_y+72.0f, "Press Square to close...");
+    platform_text_color(WHITE, BLACK);
+
+    platform_text_center(0);
+}
+
+//hot reload: pick up edits made to the profile file (e.g. over ftp) while running
+#define RELOAD_POLL_US          2000000
+
+typedef struct {
+    time_t mtime;
+    off_t size;
+    uint32_t hash;
+} FileStamp;
+
+static FileStamp profile_stamp = {0};   //contents the list was last synced with
+static FileStamp pending_stamp = {0};   //stat seen on the previous poll, for settling
+//the persister stamps its own writes while the ui thread polls
+static pthread_mutex_t stamp_lock = PTHREAD_MUTEX_INITIALIZER;
+
+//fnv-1a over the whole file, only run once mtime/size say something moved
+static int hash_file(const char *path, uint32_t *out) {
+    FILE *fp = fopen(path, "rb");
+    if(!fp) return FAILURE;
+
+    static unsigned char buf[16384];
+    uint32_t hash = 2166136261u;
+    size_t n;
+    while((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        for(size_t i = 0; i < n; i++) {
+            hash ^= buf[i];
+            hash *= 16777619u;
+        }
+    }
+    fclose(fp);
+    *out = hash;
+    return SUCCESS;
+}
+
+//record the current file as synced
+void stamp_profile_file() {
+    struct stat st;
+    pthread_mutex_lock(&stamp_lock);
+    if(stat(PROFILE_PATH, &st) == 0) {
+        profile_stamp.mtime = st.st_mtime;
+        profile_stamp.size = st.st_size;
+        hash_file(PROFILE_PATH, &profile_stamp.hash);
+        pending_stamp = profile_stamp;
+    }
+    pthread_mutex_unlock(&stamp_lock);
+}
+
+//persister hook: the file now holds what the list already has, so our own
+//appends and rewrites don't come back as an edit to reload
+void stamp_own_write(void *ctx) {
+    stamp_profile_file();
+}
+
+//1 if the contents differ from the synced stamp and the file has stopped
+//changing since the last poll (so a half-uploaded file isn't loaded).
+//caller holds stamp_lock
+static int check_profile_stamp() {
+    struct stat st;
+    if(stat(PROFILE_PATH, &st) != 0) return 0;
+    if(st.st_mtime == profile_stamp.mtime && st.st_size == profile_stamp.size) return 0;
+
+    if(st.st_mtime != pending_stamp.mtime || st.st_size != pending_stamp.size) {
+        pending_stamp.mtime = st.st_mtime;
+        pending_stamp.size = st.st_size;
+        return 0; //still being written, look again next poll
+    }
+
+    uint32_t hash;
+    if(hash_file(PROFILE_PATH, &hash) != SUCCESS) return 0;
+    profile_stamp.mtime = st.st_mtime;
+    profile_stamp.size = st.st_size;
+    if(hash == profile_stamp.hash) return 0; //touched, not edited
+    profile_stamp.hash = hash;
+    return 1;
+}
+
+static int profile_file_changed() {
+    pthread_mutex_lock(&stamp_lock);
+    int changed = check_profile_stamp();
+    pthread_mutex_unlock(&stamp_lock);
+    return changed;
+}
+
+typedef struct {
+    ProfileRow row; //first: collect_profile_field treats ctx as a ProfileRow
+    Values *list;
+    int count;
+    int capacity;
+    int failed;
+} ReloadRows;
+
+static int reload_profile_row(size_t index, size_t field_count, void *ctx) {
+    ReloadRows *rows = ctx;
+    if(index == 0 || field_count < 3) return 1;
+    if(rows->count == rows->capacity) {
+        int capacity = rows->capacity ? rows->capacity * 2 : 32;
+        Values *list = realloc(rows->list, capacity * sizeof(Values));
+        if(!list) {
+            rows->failed = 1;
+            return 0;
+        }
+        rows->list = list;
+        rows->capacity = capacity;
+    }
+    if(profile_from_row(&rows->list[rows->count], &rows->row, field_count) == SUCCESS) {
+        rows->count++;
+    }
+    return 1;
+}
+
+//slot in nameIndex holding name, or -1
+static int find_name_slot(const char *name) {
+    int slot = index_bound(nameIndex, savedValueCount, name, 0, 0);
+    if(slot < savedValueCount && strcasecmp(savedValueList[nameIndex[slot]].name, name) == 0) return slot;
+    return -1;
+}
+
+//diff the file against savedValueList and apply only what changed.
+//rows 0 and 1 ("Current", "System Default") never come from the file
+int reload_profiles_csv() {
+    ReloadRows rows = {{{NULL}}, NULL, 0, 0, 0};
+    nameset_t fileNames = {0};
+    int *remap = NULL;
+
+    if(csv_parse_stream(PROFILE_PATH, ',', collect_profile_field, reload_profile_row, &rows) != 1 || rows.failed) goto fail;
+    if(!nameset_init(&fileNames, rows.count + 1)) goto fail;
+    remap = malloc(savedValueCount * sizeof(int));
+    if(!remap) goto fail;
+
+    char cursor_name[PROFILE_NAME_SIZE] = "";
+    if(view_count() > 0) snprintf(cursor_name, sizeof(cursor_name), "%s", savedValueList[view_index(cur_pos)].name);
+
+    //rows still present: take edited addresses and settings in place. a row whose group or
+    //tags changed is left out of fileNames so it is dropped and re-added below,
+    //which files it under its new labels
+    int changed = 0;
+    for(int i = 0; i < rows.count; i++) {
+        if(!nameset_add(&fileNames, rows.list[i].name)) continue; //duplicate in file
+        int slot = find_name_slot(rows.list[i].name);
+        if(slot < 0 || nameIndex[slot] < 2) continue;
+        Values *row = &savedValueList[nameIndex[slot]];
+        if(strcmp(row->group, rows.list[i].group) != 0 || strcmp(row->tags, rows.list[i].tags) != 0) {
+            nameset_remove(&fileNames, rows.list[i].name);
+            rows.list[i].lastUsed = row->lastUsed; //carry usage over to the re-added row
+            rows.list[i].useCount = row->useCount;
+            rows.list[i].latencyMs = row->latencyMs;
+            changed++;
+        } else if(!addr_equal(&row->primaryDns, &rows.list[i].primaryDns) || !addr_equal(&row->secondaryDns, &rows.list[i].secondaryDns) ||
+                  row->netSettings != rows.list[i].netSettings) { //interned, equal strings share an offset
+            row->primaryDns = rows.list[i].primaryDns;
+            row->secondaryDns = rows.list[i].secondaryDns;
+            row->netSettings = rows.list[i].netSettings;
+            changed++;
+        }
+    }
+
+    //rows gone from the file: one compaction pass over the list and every index
+    int removed = 0;
+    for(int i = 0; i < savedValueCount; i++) {
+        remap[i] = i >= 2 && !nameset_contains(&fileNames, savedValueList[i].name) ? -1 : 0;
+        if(remap[i] < 0) removed++;
+    }
+    if(removed > 0) compact_saved_values(remap);
+
+    //rows new in the file
+    int added = 0;
+    begin_bulk_add();
+    for(int i = 0; i < rows.count; i++) {
+        if(nameset_contains(&savedNames, rows.list[i].name)) continue;
+        if(add_saved_value(&savedValueList, &savedValueCount, rows.list[i]) != SUCCESS) {
+            end_bulk_add();
+            refresh_view();
+            goto fail;
+        }
+        added++;
+    }
+    end_bulk_add();
+
+    //keep the cursor on the same profile if it survived
+    refresh_view();
+    int slot = cursor_name[0] ? find_name_slot(cursor_name) : -1;
+    select_profile(slot >= 0 ? nameIndex[slot] : -1);
+
+    netDebug("Reloaded %s: %i added, %i removed, %i changed", PROFILE_PATH, added, removed, changed);
+    free(remap);
+    nameset_free(&fileNames);
+    free(rows.list);
+    return SUCCESS;
+
+fail:
+    free(remap);
+    nameset_free(&fileNames);
+    free(rows.list);
+    return FAILURE;
+}
+
+//usage stats: rows apply in file order, so the last one for a name wins
+#define STATS_COMPACT_SLACK     64  //stale rows tolerated before the log is rewritten
+
+static int apply_stats_row(const stats_entry_t *entry, void *ctx) {
+    int slot = find_name_slot(entry->name);
+    if(slot >= 0) {
+        Values *profile = &savedValueList[nameIndex[slot]];
+        profile->lastUsed = entry->last_used;
+        profile->useCount = entry->use_count;
+    }
+    return 1;
+}
+
+//rewrite the log with one row per profile that has been used
+int compact_stats() {
+    stats_entry_t *entries = malloc(savedValueCount * sizeof(stats_entry_t));
+    if(!entries) return FAILURE;
+    size_t count = 0;
+    for(int i = 1; i < savedValueCount; i++) { //skip "Current", it can't be applied
+        if(savedValueList[i].useCount == 0) continue;
+        entries[count].name = savedValueList[i].name;
+        entries[count].last_used = savedValueList[i].lastUsed;
+        entries[count].use_count = savedValueList[i].useCount;
+        count++;
+    }
+    int ok = stats_rewrite(STATS_PATH, entries, count);
+    free(entries);
+    return ok ? SUCCESS : FAILURE;
+}
+
+int load_stats() {
+    size_t rows;
+    if(stats_load(STATS_PATH, apply_stats_row, NULL, &rows) != 1) return FAILURE;
+
+    size_t live = 0;
+    for(int i = 1; i < savedValueCount; i++) {
+        if(savedValueList[i].useCount > 0) live++;
+    }
+    if(rows > live + STATS_COMPACT_SLACK && compact_stats() != SUCCESS) {
+        netDebug("Failed to compact %s", STATS_PATH);
+    }
+
+    set_sort_order(sortOrder); //metrics changed underneath the sort index
+    return SUCCESS;
+}
+
+//low-priority timer, every RELOAD_POLL_US from the scheduler
+void poll_profile_file(void *ctx) {
+    //only while idle: our own queued writes would look like rows removed by hand
+    if(currentState != STATE_NO_DIALOG || !persist_idle()) return;
+    if(!profile_file_changed()) return;
+    frame_dirty = 1;
+    if(reload_profiles_csv() != SUCCESS) {
+        throw_error(ERR_RECOVERABLE, "Failed to reload profiles.", "The profile file changed but", "could not be read.");
+    }
+}
+
+//the registry now holds modifiedValues, reflect that without a reboot
+void sync_current_values() {
+    currentValues.dnsFlag = modifiedValues.dnsFlag;
+    currentValues.primaryDns = modifiedValues.primaryDns;
+    currentValues.secondaryDns = modifiedValues.secondaryDns;
+    savedValueList[0].dnsFlag = currentValues.dnsFlag;
+    savedValueList[0].primaryDns = currentValues.primaryDns;
+    savedValueList[0].secondaryDns = currentValues.secondaryDns;
+}
+
+//profile confirmation_apply is applying, "" for the save dialog. its use is
+//only recorded once the registry write has succeeded
+static char applyingName[PROFILE_NAME_SIZE];
+
+static void record_applied_use() {
+    if(!applyingName[0]) return;
+    int slot = find_name_slot(applyingName); //the list may have been reloaded meanwhile
+    if(slot >= 0) record_profile_use(nameIndex[slot]);
+    applyingName[0] = '\0';
+}
+
+//confirming modifiedValues: skip the write when nothing changes and the
+//reboot when only inert keys do. a reboot is the most expensive thing we do.
+//either write goes to the commit worker, the saving or restart dialog waits
+void begin_apply(xreg_registry_t *reg, int exit_after) {
+    RegistryPlan *plan = &apply_plan;
+    if(registry_commit_running()) { //the worker still reads apply_plan
+        applyingName[0] = '\0';
+        show_notice("Still saving, try again in a moment.");
+        set_state(STATE_NO_DIALOG);
+        return;
+    }
+    switch(plan_modified_values(reg, plan)) {
+        case APPLY_INVALID:
+            applyingName[0] = '\0';
+            throw_error(ERR_RECOVERABLE, "This profile can't be applied.", "A registry key is missing or a", "value doesn't fit. Nothing changed.");
+            return;
+        case APPLY_NOTHING:
+            applyingName[0] = '\0';
+            show_notice("Profile already active, nothing to change.");
+            break;
+        case APPLY_NO_REBOOT:
+            if(start_registry_commit(reg) != SUCCESS) {
+                applyingName[0] = '\0';
                 throw_error(0, "Failed to save modified values.", "The registry has not been changed.", "Check /dev_flash2/etc/xRegistry.sys exists");
+                return;
             }
-            if (difftime(current_time, last_update) >= 1.0) {
-                restart_countdown--;
-                last_update = current_time;
-
-                if (restart_countdown <= 0) {
-                    sys_ring_buzzer(2);
-                    xreg_free(reg);
-                    sys_soft_reboot();
-                }
+            saving_exit_after = exit_after;
+            set_state(STATE_SAVING_DIALOG);
+            return;
+        case APPLY_REBOOT:
+            if(start_registry_commit(reg) != SUCCESS) {
+                applyingName[0] = '\0';
+                throw_error(0, "Failed to save modified values.", "The registry has not been changed.", "Check /dev_flash2/etc/xRegistry.sys exists");
+                return;
             }
+            set_state(STATE_RESTART_DIALOG);
+            return;
+    }
+    set_state(STATE_NO_DIALOG);
+    if(exit_after) exit_requested = 1;
+}
 
-            draw_reboot_warning();
-        }
+//button handlers: the table below decides which state each one runs in
 
-        if (currentState == STATE_FIRST_RUN_DIALOG) {
-            draw_first_run_dialog();
-        }
+void back_to_table() {
+    set_state(STATE_NO_DIALOG);
+}
+
+//exit requested, check for changes, run save dialog if required.
+void request_exit() {
+    if(currentValues.dnsFlag != modifiedValues.dnsFlag) { //changes have been made, confirm exit. all other changes are made at time user selects from table
+        set_state(STATE_SAVE_DIALOG);
+    } else {
+        exit_requested = 1;     //no changes have been made, exit.
+    }
+}
+
+//save dialog: X button saves and restarts
+void save_dialog_apply() {
+    applyingName[0] = '\0';
+    begin_apply(registry, 1);
+}
+
+//save dialog: Square exits without saving.
+void save_dialog_discard() {
+    exit_requested = 1;
+}
+
+//confirmation dialog: open confirmation dialog from table
+void table_confirm() {
+    //11-10-25: disallow setting of "current" profile.
+    if(view_count() > 0 && view_index(cur_pos) != 0) {
+        set_state(STATE_CONFIRMATION_DIALOG);
+        modifiedValues = curPosValues;
+    }
+}
+
+void confirmation_apply() { //save confirmed, restart
+    snprintf(applyingName, sizeof(applyingName), "%s", modifiedValues.name);
+    begin_apply(registry, 0);
+}
 
-        if (currentState == STATE_ERROR_DIALOG) {
-            if(!error_dialog_buzzer) sys_ring_buzzer(1);
-            draw_error_dialog();
+void confirmation_cancel() { //discard changes and resume
+    set_state(STATE_NO_DIALOG);
+    modifiedValues = currentValues;
+}
+
+//deletion confirumation dialog: open from table, ignore first element
+void table_delete() {
+    if(view_count() > 0 && view_index(cur_pos) > 1) { // skip two
+        set_state(STATE_DELETION_CONFIRMATION_DIALOG); //open dialog
+    }
+}
+
+void deletion_confirm() {
+    set_state(STATE_NO_DIALOG);
+    if(delete_profile() != SUCCESS) {
+        throw_error(ERR_RECOVERABLE, "Failed to delete profile", "Perhaps the file is locked?", "Try again later");
+    }
+    netDebug("cur pos %i", cur_pos);
+    //11-10-25: instead of moving cursor up one, reset cursor to 0.
+    cur_pos = 0;
+    currentValues = savedValueList[0];
+    refresh_view();
+}
+
+//new profile dialog: open with start
+void table_new_profile() {
+    set_state(STATE_NEW_PROFILE_DIALOG);
+}
+
+void form_cancel() { //close dialog
+    //discard changes
+    reset_new_profile_form();
+    //close dialog
+    cur_pos_new_profile_dialog = 0;
+    set_state(STATE_NO_DIALOG);
+}
+
+void begin_osk_edit(const char *caption, char *buf, size_t size, void (*done)(int edited)) {
+    if(osk_begin(caption, buf, (int)size) != SUCCESS) {
+        throw_error(ERR_RECOVERABLE, "Failed to open the keyboard.", "This is most probably a bug.", "Report it on Github.");
+        return;
+    }
+    osk_edit.from = currentState;
+    osk_edit.done = done;
+    set_state(STATE_OSK);
+}
+
+//once per frame after platform_poll_system, whatever state we're in
+void poll_osk_edit() {
+    if(!osk_active()) return;
+    int result = osk_poll();
+    if(result == OSK_EDIT_PENDING) {
+        frame_dirty = 1; //the keyboard is composited on flip, it freezes if we idle
+        return;
+    }
+
+    frame_dirty = 1;
+    if(currentState == STATE_OSK) set_state(osk_edit.from); //an error may have replaced it
+    if(osk_edit.done) osk_edit.done(result == OSK_EDIT_DONE);
+}
+
+void form_edit() { //edit cur pos item value
+    if(cur_pos_new_profile_dialog == 0) { //name
+        begin_osk_edit("Name", osk_name_buf, sizeof(osk_name_buf), NULL);
+    }
+    if(cur_pos_new_profile_dialog == 1) { //primary dns
+        begin_osk_edit("Primary DNS", osk_primary_buf, sizeof(osk_primary_buf), NULL);
+    }
+    if(cur_pos_new_profile_dialog == 2) { //secondary dns
+        begin_osk_edit("Secondary DNS", osk_secondary_buf, sizeof(osk_secondary_buf), NULL);
+    }
+    if(cur_pos_new_profile_dialog == 3) { //group, optional
+        begin_osk_edit("Group (optional)", osk_group_buf, sizeof(osk_group_buf), NULL);
+    }
+    if(cur_pos_new_profile_dialog == 4) { //tags, optional
+        begin_osk_edit("Tags, separated by ; (optional)", osk_tags_buf, sizeof(osk_tags_buf), NULL);
+    }
+    if(cur_pos_new_profile_dialog == 5) { //network settings: capture from the console, or clear
+        if(osk_settings_buf[0]) {
+            osk_settings_buf[0] = '\0';
+        } else if(capture_net_settings(registry, osk_settings_buf, sizeof(osk_settings_buf)) != SUCCESS) {
+            throw_error(ERR_RECOVERABLE, "Failed to capture network settings.", "They don't fit in a profile.", "Save this profile as DNS only.");
         }
+    }
+}
 
-        if(currentState == STATE_NEW_PROFILE_DIALOG) {
-            draw_new_profile_dialog();
+void form_save() { //save values
+    //validate form
+    ValidationState valid = validate_new_profile_form();
+    if (valid == VALID) {
+        //save fields in savedValueList & to file.
+        Values newProfile;
+        make_profile(&newProfile, osk_name_buf, DNS_FLAG_MANUAL, osk_primary_buf, osk_secondary_buf, osk_group_buf, osk_tags_buf);
+        profile_set_settings(&newProfile, osk_settings_buf);
+        if(add_saved_value(&savedValueList, &savedValueCount, newProfile) != SUCCESS) {
+            throw_error(ERR_RECOVERABLE, "Failed to add the profile.", "Out of memory.", "Remove a profile and try again.");
+            return;
         }
-        
-        if (currentState == STATE_SAVE_DIALOG) {
-            draw_save_dialog();
+        refresh_view();
+        //reset form and exit
+        reset_new_profile_form();
+        set_state(STATE_NO_DIALOG);
+        if(queue_profile_add(&newProfile) != 1) {
+            throw_error(ERR_RECOVERABLE, "Failed to save to file.", "This is most probably a bug.", "Report it on Github.");
         }
+    } else {
+        throw_error(ERR_RECOVERABLE, "Invalid values in form.", validation_state_to_string(valid), "Please try again");
+    }
+}
+
+//up/down movement in form
+void form_down() { //move cur pos down
+    cur_pos_new_profile_dialog++;
+    if(cur_pos_new_profile_dialog >= NEW_PROFILE_FIELD_COUNT || cur_pos_new_profile_dialog < 0) cur_pos_new_profile_dialog = 0;
+}
+
+void form_up() { //move cur pos up
+    cur_pos_new_profile_dialog--;
+    if(cur_pos_new_profile_dialog >= NEW_PROFILE_FIELD_COUNT || cur_pos_new_profile_dialog < 0) cur_pos_new_profile_dialog = NEW_PROFILE_FIELD_COUNT - 1;
+}
+
+//search: R3 opens, wheel picks the next char, list filters as the prefix grows
+void table_search() {
+    set_state(STATE_SEARCH);
+}
+
+void search_wheel_up() {
+    search_wheel_pos = (search_wheel_pos + SEARCH_WHEEL_SIZE - 1) % SEARCH_WHEEL_SIZE;
+}
+
+void search_wheel_down() {
+    search_wheel_pos = (search_wheel_pos + 1) % SEARCH_WHEEL_SIZE;
+}
+
+void search_push_char() {
+    if(search_len < (int)sizeof(search_buf) - 1) {
+        search_buf[search_len++] = search_wheel[search_wheel_pos];
+        search_buf[search_len] = '\0';
+        cur_pos = 0;
+        refresh_view();
+    }
+}
+
+void search_pop_char() {
+    if(search_len > 0) {
+        search_buf[--search_len] = '\0';
+        cur_pos = 0;
+        refresh_view();
+    }
+}
+
+static char osk_search_buf[PROFILE_NAME_SIZE];
+
+void search_osk_done(int edited) {
+    if(edited) set_search_prefix(osk_search_buf);
+}
+
+void search_osk() {
+    snprintf(osk_search_buf, sizeof(osk_search_buf), "%s", search_buf);
+    begin_osk_edit("Search", osk_search_buf, sizeof(osk_search_buf), search_osk_done);
+}
+
+void search_clear() { //clear filter
+    set_search_prefix("");
+    set_state(STATE_NO_DIALOG);
+}
+
+//error dialog: recoverable
+void error_dismiss() {
+    if(error_recoverable == 1) set_state(STATE_NO_DIALOG);
+}
+
+void error_exit() {
+    if(error_recoverable != 1) exit_requested = 1; //not recoverable
+    else request_exit();
+}
+
+//move cursor in table
+void table_down() {
+    if (input_repeating && cur_pos >= view_count() - 1) return; //holding stops at the end, a press wraps
+    cur_pos++;
+
+    if (cur_pos >= view_count()) cur_pos = 0;
+    netDebug("Current pos: %i", cur_pos);
+    if (view_count() > 0) curPosValues = savedValueList[view_index(cur_pos)]; //set active item by cursor
+}
+
+void table_up() {
+    if (input_repeating && cur_pos <= 0) return;
+    cur_pos--;
+
+    if (cur_pos < 0) cur_pos = view_count() > 0 ? view_count() - 1 : 0;
+    netDebug("Current pos: %i", cur_pos);
+    if (view_count() > 0) curPosValues = savedValueList[view_index(cur_pos)]; //set active item by cursor
+}
+
+//switch visible group/tag
+void table_next_label() { cycle_label(1); }
+void table_prev_label() { cycle_label(-1); }
+
+//page through the table: L1/R1 a screen at a time, L2/R2 to either end
+void table_page_up()   { set_cursor(cur_pos - table_visible_rows()); }
+void table_page_down() { set_cursor(cur_pos + table_visible_rows()); }
+void table_top()       { set_cursor(0); }
+void table_bottom()    { set_cursor(view_count() - 1); }
+
+//cycle sort order
+void table_cycle_sort() {
+    set_sort_order((sortOrder + 1) % SORT_ORDER_COUNT);
+}
+
+//change dns mode
+void table_toggle_dns() {
+    modifiedValues.dnsFlag = !modifiedValues.dnsFlag;
+}
+
+//import profiles from usb/hdd
+void table_import() {
+    if(import_profiles() != SUCCESS) {
+        if(import_path == NULL) {
+            throw_error(ERR_RECOVERABLE, "No import file found.", "Place " IMPORT_FILENAME " on USB", "or in /dev_hdd0/tmp/");
+        } else if(import_out_of_memory) {
+            char added[ERR_LINE_SIZE];
+            snprintf(added, sizeof(added), "Imported %i profiles before it.", import_added);
+            throw_error(ERR_RECOVERABLE, "Import stopped, out of memory.", added, "Remove profiles and try again.");
+        } else {
+            throw_error(ERR_RECOVERABLE, "Failed to read the import file.", import_path, "Check the file and try again");
+        }
+    } else {
+        set_state(STATE_IMPORT_DIALOG);
+    }
+}
+
+typedef void (*ButtonHandler)(void);
+
+//what a fresh press does in each state. NULL ignores the button
+static const ButtonHandler button_handlers[STATE_COUNT][INPUT_BUTTON_COUNT] = {
+    [STATE_NO_DIALOG] = {
+        [INPUT_SELECT]   = request_exit,
+        [INPUT_CROSS]    = table_confirm,
+        [INPUT_CIRCLE]   = table_delete,
+        [INPUT_SQUARE]   = table_import,
+        [INPUT_TRIANGLE] = table_toggle_dns,
+        [INPUT_START]    = table_new_profile,
+        [INPUT_UP]       = table_up,
+        [INPUT_DOWN]     = table_down,
+        [INPUT_LEFT]     = table_prev_label,
+        [INPUT_RIGHT]    = table_next_label,
+        [INPUT_L1]       = table_page_up,
+        [INPUT_R1]       = table_page_down,
+        [INPUT_L2]       = table_top,
+        [INPUT_R2]       = table_bottom,
+        [INPUT_L3]       = table_cycle_sort,
+        [INPUT_R3]       = table_search,
+    },
+    [STATE_SAVE_DIALOG] = {
+        [INPUT_CROSS]    = save_dialog_apply,
+        [INPUT_CIRCLE]   = back_to_table,
+        [INPUT_SQUARE]   = save_dialog_discard,
+    },
+    [STATE_CONFIRMATION_DIALOG] = {
+        [INPUT_SELECT]   = request_exit,
+        [INPUT_CROSS]    = confirmation_apply,
+        [INPUT_CIRCLE]   = confirmation_cancel,
+    },
+    [STATE_DELETION_CONFIRMATION_DIALOG] = {
+        [INPUT_SELECT]   = request_exit,
+        [INPUT_CROSS]    = deletion_confirm,
+        [INPUT_CIRCLE]   = back_to_table,
+    },
+    [STATE_NEW_PROFILE_DIALOG] = {
+        [INPUT_SELECT]   = request_exit,
+        [INPUT_CROSS]    = form_edit,
+        [INPUT_CIRCLE]   = form_cancel,
+        [INPUT_SQUARE]   = form_save,
+        [INPUT_UP]       = form_up,
+        [INPUT_DOWN]     = form_down,
+    },
+    [STATE_FIRST_RUN_DIALOG] = {
+        [INPUT_SELECT]   = request_exit,
+        [INPUT_SQUARE]   = back_to_table,
+    },
+    [STATE_IMPORT_DIALOG] = {
+        [INPUT_SELECT]   = request_exit,
+        [INPUT_SQUARE]   = back_to_table,
+    },
+    [STATE_SEARCH] = {
+        [INPUT_SELECT]   = request_exit,
+        [INPUT_CROSS]    = back_to_table, //keep filter
+        [INPUT_CIRCLE]   = search_clear,
+        [INPUT_SQUARE]   = search_osk,
+        [INPUT_UP]       = search_wheel_up,
+        [INPUT_DOWN]     = search_wheel_down,
+        [INPUT_LEFT]     = search_pop_char,
+        [INPUT_RIGHT]    = search_push_char,
+    },
+    [STATE_ERROR_DIALOG] = {
+        [INPUT_SELECT]   = error_exit,
+        [INPUT_SQUARE]   = error_dismiss,
+    },
+    //STATE_RESTART_DIALOG and STATE_SAVING_DIALOG take no input while the
+    //registry commit runs,
+    //STATE_OSK none while the system keyboard has the pads
+};
+
+//state hooks: enter/exit run on every set_state, draw once per frame over the table
+
+void restart_tick(void *ctx) {
+    if(restart_countdown > 0) restart_countdown--;
+    frame_dirty = 1;
+}
+
+// wait for the registry commit, then restart system.
+void restart_poll(void *ctx) {
+    CommitState commit = registry_commit_state();
+    if (commit == COMMIT_FAILED) {
+        applyingName[0] = '\0';
+        netDebug("Failed to save modified values");
+        throw_error(0, "Failed to save modified values.", "The registry has not been changed.", "Check /dev_flash2/etc/xRegistry.sys exists");
+        return;
+    }
+    if (commit == COMMIT_DONE && !restart_saved) {
+        restart_saved = 1;
+        record_applied_use(); //queued before persist_stop flushes below
+        frame_dirty = 1;
+    }
+
+    //the countdown holds at 0 until the write is on flash
+    if (restart_countdown <= 0 && commit == COMMIT_DONE) {
+        restart_tick_timer = sched_cancel(restart_tick_timer);
+        restart_poll_timer = sched_cancel(restart_poll_timer);
+        platform_ring_buzzer(2);
+        persist_stop(); //flush profile writes before the reboot
+        xreg_free(registry);
+        registry = NULL;
+        platform_soft_reboot();
+    }
+}
+
+void enter_restart() {
+    restart_countdown = RESTART_SECONDS;
+    restart_saved = 0;
+    restart_tick_timer = sched_every(1000000, restart_tick, NULL);
+    restart_poll_timer = sched_every(RESTART_POLL_US, restart_poll, NULL);
+}
+
+void exit_restart() {
+    restart_tick_timer = sched_cancel(restart_tick_timer);
+    restart_poll_timer = sched_cancel(restart_poll_timer);
+}
+
+//wait for the registry commit of an apply that skips the reboot
+void saving_poll(void *ctx) {
+    CommitState commit = registry_commit_state();
+    if(commit == COMMIT_RUNNING) return;
+    if(commit == COMMIT_FAILED) {
+        applyingName[0] = '\0';
+        throw_error(0, "Failed to save modified values.", "The registry has not been changed.", "Check /dev_flash2/etc/xRegistry.sys exists");
+        return;
+    }
+    sync_current_values();
+    record_applied_use();
+    show_notice("Saved. No restart needed.");
+    set_state(STATE_NO_DIALOG);
+    if(saving_exit_after) exit_requested = 1;
+}
+
+void enter_saving() {
+    saving_poll_timer = sched_every(RESTART_POLL_US, saving_poll, NULL);
+}
+
+void exit_saving() {
+    saving_poll_timer = sched_cancel(saving_poll_timer);
+}
+
+void exit_error() {
+    error_dialog_buzzer = 0; //reset buzzer flag for next error
+}
+
+void draw_restart() {
+    draw_reboot_warning(restart_saved);
+}
+
+void draw_error() {
+    if(!error_dialog_buzzer) platform_ring_buzzer(1);
+    draw_error_dialog();
+}
+
+void draw_state(State state);
+
+void draw_osk() {
+    draw_state(osk_edit.from);
+}
+
+typedef struct {
+    void (*enter)(void);
+    void (*exit)(void);
+    void (*draw)(void);
+} StateHooks;
+
+static const StateHooks state_hooks[STATE_COUNT] = {
+    [STATE_RESTART_DIALOG]               = {enter_restart, exit_restart, draw_restart},
+    [STATE_SAVE_DIALOG]                  = {NULL, NULL, draw_save_dialog},
+    [STATE_CONFIRMATION_DIALOG]          = {NULL, NULL, draw_confirmation_dialog},
+    [STATE_DELETION_CONFIRMATION_DIALOG] = {NULL, NULL, draw_deletion_confirmation_dialog},
+    [STATE_NEW_PROFILE_DIALOG]           = {NULL, NULL, draw_new_profile_dialog},
+    [STATE_FIRST_RUN_DIALOG]             = {NULL, NULL, draw_first_run_dialog},
+    [STATE_IMPORT_DIALOG]                = {NULL, NULL, draw_import_dialog},
+    [STATE_ERROR_DIALOG]                 = {NULL, exit_error, draw_error},
+    [STATE_OSK]                          = {NULL, NULL, draw_osk},
+    [STATE_SAVING_DIALOG]                = {enter_saving, exit_saving, draw_saving_dialog},
+};
 
-        if(currentState == STATE_DELETION_CONFIRMATION_DIALOG) {
-            draw_deletion_confirmation_dialog();
+void draw_state(State state) {
+    if(state != STATE_OSK && state_hooks[state].draw) state_hooks[state].draw();
+}
+
+void set_state(State next) {
+    if(next == currentState) return;
+    if(state_hooks[currentState].exit) state_hooks[currentState].exit();
+    currentState = next;
+    frame_dirty = 1;
+    if(state_hooks[next].enter) state_hooks[next].enter();
+}
+
+//presses and repeats run the handler for the current state, if it has one.
+//each event sees the state the one before it left behind
+//L3+R3 toggles the profiler overlay. stick clicks act on release so holding
+//both never also cycles the sort or opens search
+#define PROFILER_COMBO  (INPUT_BIT(INPUT_L3) | INPUT_BIT(INPUT_R3))
+static uint32_t combo_consumed = 0; //combo buttons whose release is swallowed
+
+void dispatch_input() {
+    input_event_t ev;
+    while(input_next(&ev)) {
+        uint32_t bit = INPUT_BIT(ev.button);
+        if(bit & PROFILER_COMBO) {
+            if(ev.type == INPUT_PRESS) {
+                if(!combo_consumed && (input_held() & PROFILER_COMBO) == PROFILER_COMBO) {
+                    prof_toggle();
+                    combo_consumed = PROFILER_COMBO;
+                    frame_dirty = 1;
+                }
+                continue;
+            }
+            if(ev.type == INPUT_RELEASE && (combo_consumed & bit)) {
+                combo_consumed &= ~bit;
+                continue;
+            }
+        } else if(ev.type == INPUT_RELEASE) {
+            continue;
         }
-        if (currentState == STATE_CONFIRMATION_DIALOG) {
-           draw_confirmation_dialog();
+        ButtonHandler handler = button_handlers[currentState][ev.button];
+        if(!handler) continue;
+        input_repeating = ev.type == INPUT_REPEAT;
+        handler();
+        input_repeating = 0;
+        frame_dirty = 1;
+    }
+
+    //left stick scrolls the table
+    int rows = input_scroll();
+    if(rows && currentState == STATE_NO_DIALOG) {
+        set_cursor(cur_pos + rows);
+        frame_dirty = 1;
+    }
+}
+
+//surface background write failures through the error dialog
+#define PERSIST_POLL_US     100000
+
+//persister bursts and the registry commit, see platform_set_background
+static int background_busy() {
+    return !persist_idle() || registry_commit_running();
+}
+
+void poll_persist_errors(void *ctx) {
+    //the persister keeps the error until it's polled. the restart and saving
+    //dialogs have to see their commit through, and an error already up is read first
+    if(currentState == STATE_RESTART_DIALOG || currentState == STATE_SAVING_DIALOG ||
+       currentState == STATE_ERROR_DIALOG) return;
+    char persist_msg[ERR_LINE_SIZE]; //shown as an error line
+    if(persist_poll_error(persist_msg, sizeof(persist_msg))) {
+        throw_error(ERR_RECOVERABLE, "Failed to save profile changes.", persist_msg, "Try again later");
+    }
+}
+
+//cold start stage times, sent to netDebug once startup is done
+#define STARTUP_MARKS_MAX   16
+#define STARTUP_LOADING_STAGES  8   //marks up to "loaded", fills the loading bar
+typedef struct {
+    const char *stage;
+    uint64_t us;        //since startup_t0
+} StartupMark;
+static StartupMark startup_marks[STARTUP_MARKS_MAX];
+static int startup_mark_count = 0;
+static uint64_t startup_t0 = 0;
+static pthread_mutex_t startup_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void startup_mark(const char *stage) {
+    uint64_t now = platform_time_us();
+    pthread_mutex_lock(&startup_lock);
+    if(startup_mark_count < STARTUP_MARKS_MAX) {
+        startup_marks[startup_mark_count].stage = stage;
+        startup_marks[startup_mark_count].us = now - startup_t0;
+        startup_mark_count++;
+    }
+    pthread_mutex_unlock(&startup_lock);
+}
+
+//marks so far, the loader may be adding one
+int startup_mark_total() {
+    pthread_mutex_lock(&startup_lock);
+    int count = startup_mark_count;
+    pthread_mutex_unlock(&startup_lock);
+    return count;
+}
+
+void report_startup() {
+    for(int i = 0; i < startup_mark_count; i++) {
+        netDebug("startup: %-12s %8llu us", startup_marks[i].stage, (unsigned long long)startup_marks[i].us);
+    }
+}
+
+//what the loader found, turned into error dialogs on the ui thread once it's joined
+typedef struct {
+    int registry_ok;
+    int flag_ok;
+    int primary_ok;
+    int secondary_ok;
+    int first_run;
+    int profiles_ok;
+    int stats_ok;
+} StartupResult;
+static StartupResult startup;
+static volatile int startup_done = 0;
+
+//registry and profile data off flash, runs on the second ppu thread while
+//the first sets up the font texture and pads. touches nothing the ui thread
+//reads before the join; netDebug is already up when it starts
+void *startup_thread(void *arg) {
+    //load registry
+    registry = xreg_load(XREG_PATH);
+    startup.registry_ok = registry != NULL;
+    startup.flag_ok = get_value_int(registry, DNS_FLAG_KEY, &currentValues.dnsFlag) == SUCCESS;
+    startup.primary_ok = get_value_addr(registry, DNS_PRIMARY_KEY, &currentValues.primaryDns) == SUCCESS;
+    startup.secondary_ok = get_value_addr(registry, DNS_SECONDARY_KEY, &currentValues.secondaryDns) == SUCCESS;
+    startup_mark("registry");
+
+    //set default from system
+    modifiedValues = currentValues;
+
+    Values current = currentValues;
+    strcpy(current.name, "Current");
+    Values sys_default;
+    make_profile(&sys_default, "System Default", DNS_FLAG_AUTOMATIC, "", "", "", "");
+    int pinned_ok = add_saved_value(&savedValueList, &savedValueCount, current) == SUCCESS &&
+                    add_saved_value(&savedValueList, &savedValueCount, sys_default) == SUCCESS;
+
+    if(persist_recover(PROFILE_PATH)) netDebug("Recovered %s from an interrupted rewrite", PROFILE_PATH);
+    startup.first_run = !profiles_csv_exists(); //csv file doesnt exist assume first run
+    //create+load/load profiles csv
+    startup.profiles_ok = pinned_ok && load_profiles_csv() == SUCCESS;
+    stamp_profile_file();
+    startup_mark("profiles");
+
+    startup.stats_ok = load_stats() == SUCCESS;
+    startup_mark("stats");
+
+    startup_done = 1;
+    return NULL;
+}
+
+//shown until the loader is joined; the bar needs no font, the text does
+void draw_loading_frame(int font_ready) {
+    float z = 65535.0f;
+    float bar_w = 300.0f;
+    float bar_x = (848.0f - bar_w) / 2.0f;
+    float bar_y = 250.0f;
+    int marks = startup_mark_total();
+    int stages = marks < STARTUP_LOADING_STAGES ? marks : STARTUP_LOADING_STAGES;
+
+    platform_clear(0xff000000);
+    draw_rect(bar_x, bar_y, bar_w, 6.0f, DARK_GREY, z);
+    draw_rect(bar_x, bar_y, bar_w * stages / STARTUP_LOADING_STAGES, 6.0f, WHITE, z);
+    if(font_ready) {
+        platform_text_center(1);
+        platform_text(0, bar_y - 20.0f, "Loading profiles...");
+        platform_text_center(0);
+    }
+    platform_flip();
+}
+
+int main(int argc, char **argv) {
+    startup_t0 = platform_time_us();
+    platform_init(argc, argv);
+
+    //initialize graphics
+    platform_gfx_init();
+    startup_mark("graphics");
+
+    //initialize network/debugging, before the loader so its netDebug calls
+    //never race netDebugInit
+    platform_net_init();
+    startup_mark("network");
+
+    pthread_t loader;
+    int loader_started = pthread_create(&loader, NULL, startup_thread, NULL) == 0;
+    draw_loading_frame(0);
+    startup_mark("first frame");
+
+    //font texture, 8x13 white on black
+    platform_font_init();
+    startup_mark("font");
+
+    //initialize pad, every port
+    input_init(NULL);
+    startup_mark("pad");
+
+    if(loader_started) {
+        while(!startup_done) draw_loading_frame(1);
+        pthread_join(loader, NULL);
+    } else {
+        startup_thread(NULL); //no second thread, load in line
+    }
+    startup_mark("loaded");
+    netDebug("Hello!");
+
+    if (!startup.registry_ok) {
+        netDebug("Failed to load xRegistry file");
+        throw_error(ERR_UNRECOVERABLE, "Failed to load the xRegistry file.", "Ensure it exists at:", XREG_PATH);
+    }
+
+    if(!startup.flag_ok) {
+        netDebug("Failed to read DNS flag");
+        throw_error(ERR_UNRECOVERABLE, "Failed to read DNS flag", "This is most probably a bug.", "Report it on Github.");
+    } else {
+        netDebug("%d", currentValues.dnsFlag);
+    }
+
+    if (!startup.primary_ok) {
+        throw_error(ERR_RECOVERABLE, "Failed to read primary DNS", "This is most probably a bug.", "Report it on Github.");
+    }
+
+    if (!startup.secondary_ok) {
+        throw_error(ERR_RECOVERABLE, "Failed to read secondary DNS", "This is most probably a bug.", "Report it on Github.");
+    }
+
+    if(startup.first_run) {
+        set_state(STATE_FIRST_RUN_DIALOG);
+    }
+    if(!startup.profiles_ok) {
+        throw_error(ERR_UNRECOVERABLE, "Failed to load data.", "The file may not exist or has ", "malformed data; check for empty lines.");
+    }
+
+    if(!startup.stats_ok) {
+        netDebug("Failed to load usage stats");
+    }
+
+    //profile file writes happen off the render thread from here on
+    persist_on_write(stamp_own_write, NULL);
+    if(persist_start(PROFILE_PATH, ',', profile_header, PROFILE_HEADER_COUNT) != 1) {
+        throw_error(ERR_UNRECOVERABLE, "Failed to start the profile writer.", "This is most probably a bug.", "Report it on Github.");
+    }
+    startup_mark("ready");
+    report_startup();
+    platform_set_background(background_busy);
+
+    //background checks, on the scheduler from here on
+    sched_every(PERSIST_POLL_US, poll_persist_errors, NULL);
+    sched_every(RELOAD_POLL_US, poll_profile_file, NULL);
+
+    while(!exit_requested && platform_running()) {
+        //system events, the keyboard's included
+        platform_poll_system();
+        poll_osk_edit();
+
+        //handle pad input
+        prof_begin(PROF_INPUT);
+        input_poll();
+        dispatch_input();
+        prof_end(PROF_INPUT);
+
+        //timers and deferred work that are due
+        sched_run();
+
+        if (prof_on) frame_dirty = 1; //the overlay measures continuous frames
+        if (platform_overlay_open()) frame_dirty = 1; //the xmb only moves while we flip
+        if (!frame_dirty) {
+            platform_idle(sched_idle_us(IDLE_FRAME_US));
+            continue;
         }
+        frame_dirty = 0;
+
+        //clear screen
+        platform_clear(0xff000000);
+
+        //draw always visible elements
+        draw_header();
+        prof_begin(PROF_TABLE);
+        draw_profile_table();
+        prof_end(PROF_TABLE);
+        if (search_bar_visible()) draw_search_bar();
+        draw_notice();
+        prof_begin(PROF_CONTROLS);
+        draw_controls_box();
+        prof_end(PROF_CONTROLS);
+        draw_footer();
+
+        //dialog for the current state, if any
+        if (state_hooks[currentState].draw) state_hooks[currentState].draw();
+
+        draw_profiler();
 
-        tiny3d_Flip();
+        prof_begin(PROF_FLIP);
+        platform_flip();
+        prof_end(PROF_FLIP);
+        prof_frame();
     }
 
-    xreg_free(reg);
-    #ifdef PS3LOADX
-    sysProcessExitSpawn2("/dev_hdd0/game/PSL145310/RELOAD.SELF", NULL, NULL, NULL, 0, 1001, SYS_PROCESS_SPAWN_STACK_SIZE_1M);
-    #endif
+    persist_stop();
+    join_registry_commit(); //the loop can end mid restart countdown
+    xreg_free(registry);
+    free_saved_values();
+    input_end();
+    platform_exit();
     return 0;
 }
\ No newline at end of file
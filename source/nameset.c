@@ -0,0 +1,137 @@
+#include "nameset.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define NAMESET_MIN_CAPACITY 32u
+static char nameset_tombstone_marker;
+#define NAMESET_TOMBSTONE (&nameset_tombstone_marker)
+
+//fnv-1a over the lowercased bytes
+static uint32_t hash_folded(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) {
+        h ^= (uint8_t)tolower((unsigned char)*s++);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static char *dup_folded(const char *s) {
+    size_t len = strlen(s);
+    char *out = malloc(len + 1);
+    if (!out) return NULL;
+    for (size_t i = 0; i < len; i++) out[i] = (char)tolower((unsigned char)s[i]);
+    out[len] = '\0';
+    return out;
+}
+
+//stored keys are already folded, so only the probe side needs folding
+static int equals_folded(const char *stored, const char *name) {
+    while (*stored && *name) {
+        if (*stored != (char)tolower((unsigned char)*name)) return 0;
+        stored++;
+        name++;
+    }
+    return *stored == *name;
+}
+
+static size_t round_pow2(size_t n) {
+    size_t cap = NAMESET_MIN_CAPACITY;
+    while (cap < n) cap <<= 1;
+    return cap;
+}
+
+//returns slot holding name, or SIZE_MAX
+static size_t find_slot(const nameset_t *set, const char *name) {
+    if (!set->slots) return SIZE_MAX;
+    size_t mask = set->capacity - 1;
+    size_t i = hash_folded(name) & mask;
+    for (size_t n = 0; n < set->capacity; n++, i = (i + 1) & mask) {
+        char *slot = set->slots[i];
+        if (!slot) return SIZE_MAX;
+        if (slot != NAMESET_TOMBSTONE && equals_folded(slot, name)) return i;
+    }
+    return SIZE_MAX;
+}
+
+static void insert_folded(nameset_t *set, char *folded) {
+    size_t mask = set->capacity - 1;
+    size_t i = hash_folded(folded) & mask;
+    while (set->slots[i] && set->slots[i] != NAMESET_TOMBSTONE) i = (i + 1) & mask;
+    if (!set->slots[i]) set->used++;
+    set->slots[i] = folded;
+    set->count++;
+}
+
+static int rehash(nameset_t *set, size_t capacity) {
+    char **old = set->slots;
+    size_t old_capacity = set->capacity;
+
+    set->slots = calloc(capacity, sizeof(char *));
+    if (!set->slots) {
+        set->slots = old;
+        return 0;
+    }
+    set->capacity = capacity;
+    set->count = 0;
+    set->used = 0;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i] && old[i] != NAMESET_TOMBSTONE) insert_folded(set, old[i]);
+    }
+    free(old);
+    return 1;
+}
+
+int nameset_init(nameset_t *set, size_t capacity) {
+    if (!set) return 0;
+    memset(set, 0, sizeof(*set));
+    set->capacity = round_pow2(capacity * 2);
+    set->slots = calloc(set->capacity, sizeof(char *));
+    return set->slots != NULL;
+}
+
+void nameset_free(nameset_t *set) {
+    if (!set || !set->slots) return;
+    for (size_t i = 0; i < set->capacity; i++) {
+        if (set->slots[i] && set->slots[i] != NAMESET_TOMBSTONE) free(set->slots[i]);
+    }
+    free(set->slots);
+    memset(set, 0, sizeof(*set));
+}
+
+int nameset_contains(const nameset_t *set, const char *name) {
+    if (!set || !name) return 0;
+    return find_slot(set, name) != SIZE_MAX;
+}
+
+//returns 1 if added, 0 if already present or out of memory
+int nameset_add(nameset_t *set, const char *name) {
+    if (!set || !name) return 0;
+    if (!set->slots && !nameset_init(set, NAMESET_MIN_CAPACITY)) return 0;
+    if (find_slot(set, name) != SIZE_MAX) return 0;
+
+    //keep load (incl. tombstones) under 3/4
+    if ((set->used + 1) * 4 > set->capacity * 3) {
+        size_t capacity = set->capacity;
+        if ((set->count + 1) * 2 > capacity) capacity <<= 1; //grow, otherwise just purge tombstones
+        if (!rehash(set, capacity)) return 0;
+    }
+
+    char *folded = dup_folded(name);
+    if (!folded) return 0;
+    insert_folded(set, folded);
+    return 1;
+}
+
+//returns 1 if removed
+int nameset_remove(nameset_t *set, const char *name) {
+    if (!set || !name) return 0;
+    size_t i = find_slot(set, name);
+    if (i == SIZE_MAX) return 0;
+    free(set->slots[i]);
+    set->slots[i] = NAMESET_TOMBSTONE;
+    set->count--;
+    return 1;
+}
@@ -2,19 +2,16 @@
 //utils from https://github.com/lmirel/fm_psx/blob/master/source/util.c
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <malloc.h>
 #include <string.h>
-#include <assert.h>
-#include <unistd.h>
-#include <math.h>
 
 #include <sysutil/osk.h>
 #include <sysutil/sysutil.h>
 #include <sys/memory.h>
 #include <ppu-lv2.h>
 
-#include <tiny3d.h>
-#include "libfont2.h"
+#include "osk.h"
 
 #define OSKDIALOG_FINISHED          0x503
 #define OSKDIALOG_UNLOADED          0x504
@@ -24,34 +21,31 @@
 #define SUCCESS 	1
 #define FAILED	 	0
 
-volatile int osk_event = 0;
-volatile int osk_unloaded = 0;
 int osk_action = SUCCESS;
 
-static sys_mem_container_t container_mem;
-
 static oskCallbackReturnParam output_returned;
 static oskParam dialog_osk;
 static oskInputFieldInfo input_field;
 
+//sysutil events land here from sysUtilCheckCallback on the ui thread and are
+//handled in order by osk_poll, so nothing spins on flags
+#define OSK_EVENT_QUEUE_SIZE    8
+static u32 osk_events[OSK_EVENT_QUEUE_SIZE];
+static unsigned int osk_event_head = 0;
+static unsigned int osk_event_count = 0;
+
 static void osk_event_handler(u64 status, u64 param, void * userdata) {
 
     switch((u32) status) {
 
 	case OSKDIALOG_INPUT_CANCELED:
-		osk_event= OSKDIALOG_INPUT_CANCELED;
-		break;
-
     case OSKDIALOG_UNLOADED:
-		osk_unloaded= 1;
-		break;
-
     case OSKDIALOG_INPUT_ENTERED:
-		osk_event=OSKDIALOG_INPUT_ENTERED;
-		break;
-
 	case OSKDIALOG_FINISHED:
-		osk_event=OSKDIALOG_FINISHED;
+        if(osk_event_count < OSK_EVENT_QUEUE_SIZE) {
+            osk_events[(osk_event_head + osk_event_count) % OSK_EVENT_QUEUE_SIZE] = (u32) status;
+            osk_event_count++;
+        }
 		break;
 
     default:
@@ -59,6 +53,14 @@ static void osk_event_handler(u64 status, u64 param, void * userdata) {
     }
 }
 
+static int next_osk_event(u32 *status) {
+    if(osk_event_count == 0) return 0;
+    *status = osk_events[osk_event_head];
+    osk_event_head = (osk_event_head + 1) % OSK_EVENT_QUEUE_SIZE;
+    osk_event_count--;
+    return 1;
+}
+
 static int osk_level = 0;
 
 void utf16_to_8(u16 *stw, u8 *stb)
@@ -149,134 +151,150 @@ void utf8_to_16(u8 *stb, u16 *stw)
    *stw++ = 0;
 }
 
+//one session for the life of the app: the 8MB container, the callback and the
+//utf16 buffers are set up on the first edit and reused by every edit after it
+#define OSK_MESSAGE_CHARS   128
+#define OSK_TEXT_CHARS      0x420
+
+typedef struct {
+    int open;
+    int exit_registered;
+    sys_mem_container_t container;
+    u16 message[OSK_MESSAGE_CHARS];
+    u16 in[OSK_TEXT_CHARS];
+    u16 out[OSK_TEXT_CHARS];
+    u8 text[OSK_TEXT_CHARS * 3]; //utf8 of out, worst case 3 bytes per unit
+    char *dest;                  //caller's buffer for the edit in progress
+    size_t dest_size;
+} osk_session_t;
+
+static osk_session_t session;
+
 static void OSK_exit(void)
 {
     if(osk_level == 2) {
         oskAbort();
         oskUnloadAsync(&output_returned);
         
-        osk_event = 0;
         osk_action=FAILED;
     }
 
     if(osk_level >= 1) {
         sysUtilUnregisterCallback(SYSUTIL_EVENT_SLOT0);
-        sysMemContainerDestroy(container_mem);
+        sysMemContainerDestroy(session.container);
+        session.open = 0;
     }
 
+    osk_level = 0;
 }
 
-int get_osk_string(char *caption, 
-                    char *str, 
-                    int len) {
-    int ret=SUCCESS;
-
-    u16 * message = NULL;
-    u16 * out = NULL;
-    u16 * in = NULL;
+int osk_session_open(void) {
+    if(session.open) return SUCCESS;
 
-    if(len > 256) len = 256; //will never be >256 but to be safe
+    if(!session.exit_registered) {
+        atexit(OSK_exit);
+        session.exit_registered = 1;
+    }
 
-    osk_level = 0;
-    atexit(OSK_exit);
+    if(sysMemContainerCreate(&session.container, 8*1024*1024) < 0) return FAILED;
 
-    if(sysMemContainerCreate(&container_mem, 8*1024*1024) < 0) return FAILED;
+    sysUtilUnregisterCallback(SYSUTIL_EVENT_SLOT0);
+    sysUtilRegisterCallback(SYSUTIL_EVENT_SLOT0, osk_event_handler, NULL);
 
+    session.open = 1;
     osk_level = 1;
+    return SUCCESS;
+}
 
-    message = malloc(strlen(caption)*2+32);
-    if(!message) {ret=FAILED; goto end;}
+void osk_session_close(void) {
+    OSK_exit();
+}
 
-    out = malloc(0x420*2);
-    if(!out) {ret=FAILED; goto end;}
+int osk_active(void) {
+    return osk_level == 2;
+}
+
+int osk_begin(const char *caption, char *str, int len) {
+    if(osk_level == 2) return FAILED; //one edit at a time
+    if(len > 256) len = 256; //will never be >256 but to be safe
 
-    in = malloc(0x420*2);
-    if(!in) {ret=FAILED; goto end;}
+    //utf16 never needs more units than utf8 has bytes
+    if(strlen(caption) >= OSK_MESSAGE_CHARS || strlen(str) >= OSK_TEXT_CHARS) return FAILED;
 
-    //memset(message, 0, 64);
-    utf8_to_16((u8 *) caption, (u16 *) message);
-    utf8_to_16((u8 *) str, (u16 *) in);
+    if(osk_session_open() != SUCCESS) return FAILED;
 
-    input_field.message =  (u16 *) message;
-    input_field.startText = (u16 *) in;
+    utf8_to_16((u8 *) caption, session.message);
+    utf8_to_16((u8 *) str, session.in);
+    session.dest = str;
+    session.dest_size = (size_t) len;
+
+    input_field.message = session.message;
+    input_field.startText = session.in;
     input_field.maxLength = len;
 
     output_returned.res = OSK_NO_TEXT; //OSK_OK;
     output_returned.len = len;
 
-    output_returned.str = (u16 *) out;
+    output_returned.str = session.out;
 
-    memset(out, 0, 1024);
+    memset(session.out, 0, sizeof(session.out));
 
-    if(oskSetKeyLayoutOption (OSK_10KEY_PANEL | OSK_FULLKEY_PANEL)<0) {ret=FAILED; goto end;}
+    //layout options only apply to the next load, so they're set every time
+    if(oskSetKeyLayoutOption (OSK_10KEY_PANEL | OSK_FULLKEY_PANEL)<0) return FAILED;
 
     dialog_osk.firstViewPanel = OSK_PANEL_TYPE_ALPHABET_FULL_WIDTH;
     dialog_osk.allowedPanels = (OSK_PANEL_TYPE_ALPHABET | OSK_PANEL_TYPE_NUMERAL);
 
-    if(oskAddSupportLanguage ( OSK_PANEL_TYPE_ALPHABET )<0) {ret=FAILED; goto end;}
+    if(oskAddSupportLanguage ( OSK_PANEL_TYPE_ALPHABET )<0) return FAILED;
 
-    if(oskSetLayoutMode( OSK_LAYOUTMODE_HORIZONTAL_ALIGN_CENTER )<0) {ret=FAILED; goto end;}
+    if(oskSetLayoutMode( OSK_LAYOUTMODE_HORIZONTAL_ALIGN_CENTER )<0) return FAILED;
 
     oskPoint pos = {0.0, 0.0};
 
     dialog_osk.controlPoint = pos;
     dialog_osk.prohibitFlags = OSK_PROHIBIT_RETURN;
-    if(oskSetInitialInputDevice(OSK_DEVICE_PAD)<0) {ret=FAILED; goto end;}
-
-    sysUtilUnregisterCallback(SYSUTIL_EVENT_SLOT0);
-    sysUtilRegisterCallback(SYSUTIL_EVENT_SLOT0, osk_event_handler, NULL);
+    if(oskSetInitialInputDevice(OSK_DEVICE_PAD)<0) return FAILED;
 
     osk_action = SUCCESS;
-    osk_unloaded = false;
+    osk_event_head = osk_event_count = 0; //nothing left over from the last edit
 
-    if(oskLoadAsync(container_mem, (const void *) &dialog_osk, (const void *)  &input_field)<0) {ret=FAILED; goto end;}
+    if(oskLoadAsync(session.container, (const void *) &dialog_osk, (const void *)  &input_field)<0) return FAILED;
 
     osk_level = 2;
+    return SUCCESS;
+}
 
-    while(!osk_unloaded)
-    {
-		tiny3d_Flip();
+int osk_poll(void) {
+    if(osk_level != 2) return OSK_EDIT_NONE;
 
-        switch(osk_event)
+    u32 status;
+    while(next_osk_event(&status)) {
+        switch(status)
         {
             case OSKDIALOG_INPUT_ENTERED:
                 oskGetInputText(&output_returned);
-                osk_event = 0;
                 break;
 
             case OSKDIALOG_INPUT_CANCELED:
                 oskAbort();
                 oskUnloadAsync(&output_returned);
-                osk_event  = 0;
                 osk_action = FAILED;
                 break;
 
             case OSKDIALOG_FINISHED:
                 oskUnloadAsync(&output_returned);
-                osk_event = 0;
                 break;
 
+            case OSKDIALOG_UNLOADED:
+                osk_level = 1; //the container is free for the next edit
+                if(output_returned.res != OSK_OK || osk_action != SUCCESS) return OSK_EDIT_CANCELED;
+                utf16_to_8(session.out, session.text);
+                snprintf(session.dest, session.dest_size, "%s", (char *) session.text);
+                return OSK_EDIT_DONE;
+
             default:
                 break;
         }
-
     }
-
-    //usleep(150000); 
-
-    if(output_returned.res == OSK_OK && osk_action == SUCCESS)
-		utf16_to_8((u16 *) out, (u8 *) str);
-    else ret=FAILED;
-
-end:
-
-    sysUtilUnregisterCallback(SYSUTIL_EVENT_SLOT0);
-    sysMemContainerDestroy(container_mem);
-
-    osk_level = 0;
-    if(message) free(message);
-    if(out) free(out);
-    if(in) free(in);
-
-    return ret;
-}
\ No newline at end of file
+    return OSK_EDIT_PENDING;
+}
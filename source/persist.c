@@ -0,0 +1,378 @@
+#include "persist.h"
+#include "csv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define PERSIST_COALESCE_US     50000   //after waking, let the rest of a burst arrive
+#define PERSIST_ERROR_SIZE      128
+
+typedef enum {
+    PERSIST_ADD,
+    PERSIST_REMOVE,
+    PERSIST_CALL
+} persist_op_type_t;
+
+typedef struct persist_op {
+    persist_op_type_t type;
+    char **fields;          //fields[0] is the key, remove carries only the key
+    size_t count;
+    persist_fn_t fn;        //PERSIST_CALL only
+    void *ctx;
+    struct persist_op *next;
+} persist_op_t;
+
+static pthread_t persist_tid;
+static pthread_mutex_t persist_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t persist_cond = PTHREAD_COND_INITIALIZER;
+static int persist_running = 0;
+static int persist_stopping = 0;
+static int persist_writing = 0;     //a batch has been taken off the queue and is being written
+
+static persist_op_t *queue_head = NULL;
+static persist_op_t *queue_tail = NULL;
+
+static char *persist_path = NULL;
+static char *persist_tmp_path = NULL;
+static char persist_delimiter = ',';
+static char **persist_header = NULL;
+static size_t persist_header_count = 0;
+
+static persist_fn_t written_fn = NULL;
+static void *written_ctx = NULL;
+
+static char persist_error[PERSIST_ERROR_SIZE];
+static int persist_error_pending = 0;
+
+//pointers and strings in one block, an import queues thousands of rows
+static char **dup_fields(char **fields, size_t count) {
+    size_t size = count * sizeof(char *);
+    for (size_t i = 0; i < count; i++) size += strlen(fields[i] ? fields[i] : "") + 1;
+    char **out = malloc(size);
+    if (!out) return NULL;
+    char *p = (char *)(out + count);
+    for (size_t i = 0; i < count; i++) {
+        size_t len = strlen(fields[i] ? fields[i] : "") + 1;
+        memcpy(p, fields[i] ? fields[i] : "", len);
+        out[i] = p;
+        p += len;
+    }
+    return out;
+}
+
+static void free_op(persist_op_t *op) {
+    free(op->fields);
+    free(op);
+}
+
+static void set_error(const char *msg) {
+    pthread_mutex_lock(&persist_lock);
+    snprintf(persist_error, sizeof(persist_error), "%s", msg);
+    persist_error_pending = 1;
+    pthread_mutex_unlock(&persist_lock);
+}
+
+static void push_op(persist_op_t *op) {
+    pthread_mutex_lock(&persist_lock);
+    if (queue_tail) queue_tail->next = op;
+    else queue_head = op;
+    queue_tail = op;
+    pthread_cond_signal(&persist_cond);
+    pthread_mutex_unlock(&persist_lock);
+}
+
+static int enqueue(persist_op_type_t type, char **fields, size_t count) {
+    if (!persist_running || !fields || count == 0) return 0;
+
+    persist_op_t *op = calloc(1, sizeof(*op));
+    if (!op) return 0;
+    op->type = type;
+    op->count = count;
+    op->fields = dup_fields(fields, count);
+    if (!op->fields) {
+        free(op);
+        return 0;
+    }
+    push_op(op);
+    return 1;
+}
+
+int persist_add(char **fields, size_t count) {
+    return enqueue(PERSIST_ADD, fields, count);
+}
+
+int persist_remove(const char *key) {
+    char *fields[] = {(char *)key};
+    return enqueue(PERSIST_REMOVE, fields, 1);
+}
+
+int persist_run(persist_fn_t fn, void *ctx) {
+    if (!persist_running || !fn) return 0;
+    persist_op_t *op = calloc(1, sizeof(*op));
+    if (!op) return 0;
+    op->type = PERSIST_CALL;
+    op->fn = fn;
+    op->ctx = ctx;
+    push_op(op);
+    return 1;
+}
+
+void persist_on_write(persist_fn_t fn, void *ctx) {
+    written_fn = fn;
+    written_ctx = ctx;
+}
+
+int persist_idle(void) {
+    int idle;
+    pthread_mutex_lock(&persist_lock);
+    idle = !queue_head && !persist_writing;
+    pthread_mutex_unlock(&persist_lock);
+    return idle;
+}
+
+int persist_poll_error(char *msg, size_t msg_size) {
+    int pending;
+    pthread_mutex_lock(&persist_lock);
+    pending = persist_error_pending;
+    if (pending) {
+        snprintf(msg, msg_size, "%s", persist_error);
+        persist_error_pending = 0;
+    }
+    pthread_mutex_unlock(&persist_lock);
+    return pending;
+}
+
+//rewrite pass: copies every row of the old file except the removed keys
+typedef struct {
+    CSVBuffer *out;
+    const char **removed;
+    size_t nremoved;
+    char **row;
+    size_t row_count;
+    size_t row_cap;
+    int failed;
+} persist_rewrite_t;
+
+static int rewrite_field(const char *field, size_t len, size_t col, void *ctx) {
+    persist_rewrite_t *rw = ctx;
+    if (rw->row_count == rw->row_cap) {
+        size_t cap = rw->row_cap ? rw->row_cap * 2 : 8;
+        char **row = realloc(rw->row, cap * sizeof(char *));
+        if (!row) { rw->failed = 1; return 0; }
+        rw->row = row;
+        rw->row_cap = cap;
+    }
+    rw->row[rw->row_count++] = (char *)field;
+    return 1;
+}
+
+static int rewrite_row(size_t index, size_t field_count, void *ctx) {
+    persist_rewrite_t *rw = ctx;
+    size_t count = rw->row_count;
+    rw->row_count = 0;
+    if (count == 0) return 1; //drop blank lines
+
+    if (index > 0) {
+        for (size_t i = 0; i < rw->nremoved; i++) {
+            if (strcmp(rw->removed[i], rw->row[0]) == 0) return 1;
+        }
+    }
+    if (!csv_buffer_add_row(rw->out, rw->row, count, persist_delimiter)) {
+        rw->failed = 1;
+        return 0;
+    }
+    return 1;
+}
+
+//write to a temp file first so a failed write never truncates the profiles.
+//the temp file is on disk before the old one goes, so persist_recover always
+//has a complete copy to rename back
+static int replace_file(const CSVBuffer *buf) {
+    FILE *fp = fopen(persist_tmp_path, "w");
+    if (!fp) return 0;
+    size_t written = buf->len ? fwrite(buf->data, 1, buf->len, fp) : 0;
+    int synced = fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    if (fclose(fp) != 0 || written != buf->len || !synced) {
+        unlink(persist_tmp_path);
+        return 0;
+    }
+    unlink(persist_path); //rename won't replace an existing file on every fs
+    return rename(persist_tmp_path, persist_path) == 0;
+}
+
+static int is_removed(const char **removed, size_t nremoved, const char *key) {
+    for (size_t i = 0; i < nremoved; i++) {
+        if (strcmp(removed[i], key) == 0) return 1;
+    }
+    return 0;
+}
+
+//fold a burst of operations into new rows + removed keys, then write once.
+//failures are reported through persist_poll_error, the file is left as it
+//was. returns 1 if the file was written
+static int apply_batch(persist_op_t *batch) {
+    size_t nops = 0;
+    for (persist_op_t *op = batch; op; op = op->next) nops++;
+
+    persist_op_t **adds = calloc(nops, sizeof(persist_op_t *));
+    const char **removed = calloc(nops, sizeof(const char *));
+    if (!adds || !removed) {
+        free(adds);
+        free(removed);
+        set_error("Could not write the profile file.");
+        return 0;
+    }
+    size_t nadds = 0;
+    size_t nremoved = 0;
+
+    for (persist_op_t *op = batch; op; op = op->next) {
+        if (op->type == PERSIST_CALL) continue;
+        const char *key = op->fields[0];
+        if (op->type == PERSIST_ADD) {
+            adds[nadds++] = op;
+            continue;
+        }
+        for (size_t i = 0; i < nadds; i++) {
+            if (adds[i] && strcmp(adds[i]->fields[0], key) == 0) adds[i] = NULL;
+        }
+        if (!is_removed(removed, nremoved, key)) removed[nremoved++] = key;
+    }
+
+    if (nadds == 0 && nremoved == 0) { //only calls in this burst
+        free(adds);
+        free(removed);
+        return 0;
+    }
+
+    CSVBuffer out = {0};
+    int ok = 1;
+    int unreadable = 0;
+
+    if (nremoved > 0) {
+        persist_rewrite_t rw = {&out, removed, nremoved, NULL, 0, 0, 0};
+        errno = 0;
+        if (!csv_parse_stream(persist_path, persist_delimiter, rewrite_field, rewrite_row, &rw)) {
+            //only a file that isn't there yet may start over from the header,
+            //any other failed read would write the rows it missed away
+            ok = !rw.failed && out.len == 0 && errno == ENOENT;
+            unreadable = !ok && !rw.failed;
+        }
+        if (ok && out.len == 0 && persist_header)
+            ok = csv_buffer_add_row(&out, persist_header, persist_header_count, persist_delimiter);
+        free(rw.row);
+    }
+
+    for (size_t i = 0; ok && i < nadds; i++) {
+        if (adds[i]) ok = csv_buffer_add_row(&out, adds[i]->fields, adds[i]->count, persist_delimiter);
+    }
+
+    if (ok) ok = nremoved > 0 ? replace_file(&out) : csv_append_buffer(persist_path, &out);
+    if (!ok) set_error(unreadable ? "Could not read the profile file." : "Could not write the profile file.");
+
+    csv_buffer_free(&out);
+    free(adds);
+    free(removed);
+    return ok;
+}
+
+static void *persist_thread(void *arg) {
+    pthread_mutex_lock(&persist_lock);
+    for (;;) {
+        while (!queue_head && !persist_stopping) pthread_cond_wait(&persist_cond, &persist_lock);
+        if (!queue_head) break; //stopping and drained
+
+        if (!persist_stopping) {
+            pthread_mutex_unlock(&persist_lock);
+            usleep(PERSIST_COALESCE_US);
+            pthread_mutex_lock(&persist_lock);
+        }
+
+        persist_op_t *batch = queue_head;
+        queue_head = queue_tail = NULL;
+        persist_writing = 1;
+        pthread_mutex_unlock(&persist_lock);
+
+        if (apply_batch(batch) && written_fn) written_fn(written_ctx);
+
+        while (batch) {
+            persist_op_t *next = batch->next;
+            if (batch->type == PERSIST_CALL) batch->fn(batch->ctx);
+            free_op(batch);
+            batch = next;
+        }
+        pthread_mutex_lock(&persist_lock);
+        persist_writing = 0;
+    }
+    pthread_mutex_unlock(&persist_lock);
+    return NULL;
+}
+
+int persist_recover(const char *path) {
+    if (!path) return 0;
+    FILE *fp = fopen(path, "r");
+    if (fp) {
+        fclose(fp);
+        return 0;
+    }
+
+    size_t len = strlen(path);
+    char *tmp_path = malloc(len + 5);
+    if (!tmp_path) return 0;
+    memcpy(tmp_path, path, len);
+    memcpy(tmp_path + len, ".tmp", 5);
+    int recovered = rename(tmp_path, path) == 0;
+    free(tmp_path);
+    return recovered;
+}
+
+int persist_start(const char *path, char delimiter, char **header, size_t header_count) {
+    if (persist_running || !path) return 0;
+
+    size_t len = strlen(path);
+    persist_path = strdup(path);
+    persist_tmp_path = malloc(len + 5);
+    if (!persist_path || !persist_tmp_path) goto fail;
+    memcpy(persist_tmp_path, path, len);
+    memcpy(persist_tmp_path + len, ".tmp", 5);
+
+    persist_delimiter = delimiter;
+    persist_header_count = header_count;
+    if (header && header_count > 0) {
+        persist_header = dup_fields(header, header_count);
+        if (!persist_header) goto fail;
+    }
+
+    persist_stopping = 0;
+    if (pthread_create(&persist_tid, NULL, persist_thread, NULL) != 0) goto fail;
+    persist_running = 1;
+    return 1;
+
+fail:
+    free(persist_path);
+    free(persist_tmp_path);
+    persist_path = persist_tmp_path = NULL;
+    free(persist_header);
+    persist_header = NULL;
+    return 0;
+}
+
+void persist_stop(void) {
+    if (!persist_running) return;
+
+    pthread_mutex_lock(&persist_lock);
+    persist_stopping = 1;
+    pthread_cond_signal(&persist_cond);
+    pthread_mutex_unlock(&persist_lock);
+    pthread_join(persist_tid, NULL);
+    persist_running = 0;
+
+    free(persist_path);
+    free(persist_tmp_path);
+    persist_path = persist_tmp_path = NULL;
+    free(persist_header);
+    persist_header = NULL;
+}
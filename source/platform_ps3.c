@@ -0,0 +1,204 @@
+#include "platform.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#include <io/pad.h>
+#include <net/net.h>
+#include <sysutil/sysutil.h>
+#include <sys/process.h>
+#include <sys/systime.h>
+#include <ppu-lv2.h>
+#include <tiny3d.h>
+#include <libfont2.h>
+
+#include "font.h"
+#include "debug.h"
+#include "profiler.h"
+
+#define TEXT_BUFFER_SIZE    1024
+
+//slot 0 belongs to the keyboard, see osk.c
+#define SYSTEM_EVENT_SLOT   SYSUTIL_EVENT_SLOT1
+
+static int menu_open = 0;       //ps button menu
+static int system_drawing = 0;  //system dialogs, between draw begin and end
+
+static void system_event(u64 status, u64 param, void *userdata) {
+    switch ((u32)status) {
+        case SYSUTIL_MENU_OPEN:  menu_open = 1; break;
+        case SYSUTIL_MENU_CLOSE: menu_open = 0; break;
+        case SYSUTIL_DRAW_BEGIN: system_drawing = 1; break;
+        case SYSUTIL_DRAW_END:   system_drawing = 0; break;
+    }
+}
+
+void platform_init(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    sysUtilRegisterCallback(SYSTEM_EVENT_SLOT, system_event, NULL);
+}
+
+int platform_running(void) {
+    return 1;
+}
+
+uint64_t platform_time_us(void) {
+    return sysGetSystemTime();
+}
+
+void platform_idle(uint32_t us) {
+    usleep(us);
+}
+
+void platform_set_background(int (*busy)(void)) {
+    (void)busy; //real time, the threads simply run alongside
+}
+
+void platform_gfx_init(void) {
+    tiny3d_Init(1024*1024);
+    tiny3d_Project2D();
+}
+
+void platform_font_init(void) {
+    u32 * texture_mem = tiny3d_AllocTexture(170*1024*1024);
+    u32 * texture_pointer;
+    if(!texture_mem) return; //whomp
+    texture_pointer = texture_mem;
+    ResetFont();
+    texture_pointer = (u32 *) AddFontFromBitmapArray((u8 *) font  , (u8 *) texture_pointer, 32, 255, 16, 32, 2, BIT0_FIRST_PIXEL);
+
+    SetCurrentFont(0);
+    SetFontSize(8,13);
+    SetFontColor(0xFFFFFFFF, 0x00000000);
+    SetFontAutoCenter(0);
+    SetFontZ(65535.0f);
+}
+
+void platform_clear(uint32_t color) {
+    tiny3d_Clear(color, TINY3D_CLEAR_ALL);
+}
+
+void platform_flip(void) {
+    tiny3d_Flip();
+}
+
+void platform_quad(float x, float y, float w, float h, uint32_t color, float z) {
+    tiny3d_SetPolygon(TINY3D_QUADS);
+
+    tiny3d_VertexPos(x, y, z);
+    tiny3d_VertexColor(color);
+
+    tiny3d_VertexPos(x + w, y, z);
+    tiny3d_VertexColor(color);
+
+    tiny3d_VertexPos(x + w, y + h, z);
+    tiny3d_VertexColor(color);
+
+    tiny3d_VertexPos(x, y + h, z);
+    tiny3d_VertexColor(color);
+
+    tiny3d_End();
+    prof_draw(4);
+}
+
+float platform_text(float x, float y, const char *str) {
+    return DrawString(x, y, (char *)str);
+}
+
+float platform_textf(float x, float y, const char *fmt, ...) {
+    char buf[TEXT_BUFFER_SIZE];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return DrawString(x, y, buf);
+}
+
+void platform_text_color(uint32_t color, uint32_t bkcolor) {
+    SetFontColor(color, bkcolor);
+}
+
+void platform_text_center(int on) {
+    SetFontAutoCenter(on);
+}
+
+void platform_pad_init(void) {
+    ioPadInit(PLATFORM_PADS);
+}
+
+void platform_pad_end(void) {
+    ioPadEnd();
+}
+
+int platform_pad_read(int port, platform_pad_t *pad) {
+    static padInfo info;
+    padData data;
+
+    if (port == 0) ioPadGetInfo(&info); //once per sweep over the ports
+    if (!info.status[port]) return PLATFORM_PAD_NONE;
+    //len 0 means no new report, the pad is still in its last state
+    if (ioPadGetData(port, &data) != 0 || data.len == 0) return PLATFORM_PAD_SAME;
+
+    uint32_t mask = 0;
+    if (data.BTN_SELECT)   mask |= INPUT_BIT(INPUT_SELECT);
+    if (data.BTN_CROSS)    mask |= INPUT_BIT(INPUT_CROSS);
+    if (data.BTN_CIRCLE)   mask |= INPUT_BIT(INPUT_CIRCLE);
+    if (data.BTN_SQUARE)   mask |= INPUT_BIT(INPUT_SQUARE);
+    if (data.BTN_TRIANGLE) mask |= INPUT_BIT(INPUT_TRIANGLE);
+    if (data.BTN_START)    mask |= INPUT_BIT(INPUT_START);
+    if (data.BTN_UP)       mask |= INPUT_BIT(INPUT_UP);
+    if (data.BTN_DOWN)     mask |= INPUT_BIT(INPUT_DOWN);
+    if (data.BTN_LEFT)     mask |= INPUT_BIT(INPUT_LEFT);
+    if (data.BTN_RIGHT)    mask |= INPUT_BIT(INPUT_RIGHT);
+    if (data.BTN_L1)       mask |= INPUT_BIT(INPUT_L1);
+    if (data.BTN_R1)       mask |= INPUT_BIT(INPUT_R1);
+    if (data.BTN_L2)       mask |= INPUT_BIT(INPUT_L2);
+    if (data.BTN_R2)       mask |= INPUT_BIT(INPUT_R2);
+    if (data.BTN_L3)       mask |= INPUT_BIT(INPUT_L3);
+    if (data.BTN_R3)       mask |= INPUT_BIT(INPUT_R3);
+    pad->buttons = mask;
+    pad->stick_v = data.ANA_L_V;
+    return PLATFORM_PAD_NEW;
+}
+
+void platform_net_init(void) {
+    netInitialize();
+    netDebugInit();
+}
+
+void platform_poll_system(void) {
+    sysUtilCheckCallback();
+}
+
+int platform_overlay_open(void) {
+    return menu_open || system_drawing;
+}
+
+void platform_ring_buzzer(int beeps) {
+    if (beeps < 1) beeps = 1;
+    if (beeps > 3) beeps = 3;
+
+    static const uint64_t args[3][3] = {
+        {0x1004, 0x4, 0x6},     //single beep
+        {0x1004, 0x7, 0x36},    //two beeps
+        {0x1004, 0xa, 0x1b6}    //three beeps
+    };
+
+    lv2syscall3(392, args[beeps - 1][0], args[beeps - 1][1], args[beeps - 1][2]);
+}
+
+int platform_soft_reboot(void) {
+    unlink("/dev_hdd0/tmp/turnoff"); //delete turnoff file to avoid bad reboot
+    lv2syscall3(379, 0x0200, 0, 0);
+
+    return_to_user_prog(int);
+}
+
+void platform_exit(void) {
+    sysUtilUnregisterCallback(SYSTEM_EVENT_SLOT);
+    #ifdef PS3LOADX
+    sysProcessExitSpawn2("/dev_hdd0/game/PSL145310/RELOAD.SELF", NULL, NULL, NULL, 0, 1001, SYS_PROCESS_SPAWN_STACK_SIZE_1M);
+    #endif
+}
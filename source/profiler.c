@@ -0,0 +1,112 @@
+#include "profiler.h"
+#include "platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+#if defined(__powerpc__) || defined(__powerpc64__)
+#include <sys/systime.h>
+#endif
+
+#define PROF_REFRESH_FRAMES     30  //percentiles are re-sorted twice a second, not every frame
+
+int prof_on = 0;
+uint64_t prof_scope_start[PROF_SCOPE_COUNT];
+uint64_t prof_scope_ticks[PROF_SCOPE_COUNT];
+uint32_t prof_draw_calls = 0;
+uint32_t prof_vertices = 0;
+
+static uint32_t history[PROF_HISTORY];     //frame to frame, in ticks
+static unsigned int history_pos = 0;
+static unsigned int history_count = 0;
+static uint64_t last_frame = 0;
+
+static uint64_t scope_window[PROF_SCOPE_COUNT];
+static unsigned int window_frames = 0;
+static prof_stats_t cached;
+
+uint64_t prof_ticks(void) {
+#if defined(__powerpc__) || defined(__powerpc64__)
+    uint64_t tb;
+    __asm__ volatile ("mftb %0" : "=r" (tb));
+    return tb;
+#else
+    return platform_time_us(); //when there is no timebase register
+#endif
+}
+
+static uint64_t ticks_per_second(void) {
+#if defined(__powerpc__) || defined(__powerpc64__)
+    static uint64_t freq = 0;
+    if (!freq) freq = sysGetTimebaseFrequency();
+    return freq;
+#else
+    return 1000000;
+#endif
+}
+
+void prof_toggle(void) {
+    prof_on = !prof_on;
+    history_pos = history_count = 0;
+    last_frame = 0;
+    window_frames = 0;
+    memset(prof_scope_ticks, 0, sizeof(prof_scope_ticks));
+    memset(scope_window, 0, sizeof(scope_window));
+    memset(&cached, 0, sizeof(cached));
+}
+
+static int cmp_ticks(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void refresh(void) {
+    float ms_per_tick = 1000.0f / (float)ticks_per_second();
+
+    if (history_count > 0) {
+        uint32_t sorted[PROF_HISTORY];
+        uint64_t total = 0;
+        memcpy(sorted, history, history_count * sizeof(uint32_t));
+        for (unsigned int i = 0; i < history_count; i++) total += sorted[i];
+        qsort(sorted, history_count, sizeof(uint32_t), cmp_ticks);
+
+        unsigned int p99 = history_count * 99 / 100;
+        if (p99 >= history_count) p99 = history_count - 1;
+        cached.p50_ms = sorted[history_count / 2] * ms_per_tick;
+        cached.p99_ms = sorted[p99] * ms_per_tick;
+        cached.fps = total ? (float)history_count * 1000.0f / (total * ms_per_tick) : 0.0f;
+    }
+
+    for (int s = 0; s < PROF_SCOPE_COUNT; s++) {
+        cached.scope_ms[s] = window_frames ? scope_window[s] * ms_per_tick / window_frames : 0.0f;
+        scope_window[s] = 0;
+    }
+    window_frames = 0;
+}
+
+void prof_frame(void) {
+    if (prof_on) {
+        uint64_t now = prof_ticks();
+        if (last_frame) {
+            uint64_t dt = now - last_frame;
+            history[history_pos] = dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt;
+            history_pos = (history_pos + 1) % PROF_HISTORY;
+            if (history_count < PROF_HISTORY) history_count++;
+        }
+        last_frame = now;
+
+        for (int s = 0; s < PROF_SCOPE_COUNT; s++) {
+            scope_window[s] += prof_scope_ticks[s];
+            prof_scope_ticks[s] = 0;
+        }
+        cached.draw_calls = prof_draw_calls;
+        cached.vertices = prof_vertices;
+        if (++window_frames >= PROF_REFRESH_FRAMES) refresh();
+    }
+    prof_draw_calls = 0;
+    prof_vertices = 0;
+}
+
+void prof_stats(prof_stats_t *out) {
+    *out = cached;
+}
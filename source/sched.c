@@ -0,0 +1,125 @@
+#include "sched.h"
+#include "platform.h"
+
+#include <stddef.h>
+
+#define SLOT_BITS       8
+#define SLOT_MASK       ((1 << SLOT_BITS) - 1)
+#define GEN_MAX         0x7FFFFF    //ids stay positive
+
+typedef struct {
+    sched_id_t id;          //SCHED_NONE while the slot is free
+    uint64_t deadline;      //us, 0 = next run
+    uint64_t interval;      //us, 0 for one-shots
+    unsigned int epoch;     //run it was added in, it waits for the next one
+    sched_fn_t fn;
+    void *ctx;
+} sched_task_t;
+
+static sched_task_t tasks[SCHED_MAX_TASKS];
+static unsigned int slot_gen[SCHED_MAX_TASKS];
+static unsigned int run_epoch = 0;
+static uint64_t run_now = 0;
+static uint64_t frame_us = 0;
+
+static sched_id_t add_task(uint64_t deadline, uint64_t interval, sched_fn_t fn, void *ctx) {
+    if (!fn) return SCHED_NONE;
+    for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+        sched_task_t *t = &tasks[i];
+        if (t->id != SCHED_NONE) continue;
+
+        slot_gen[i] = slot_gen[i] % GEN_MAX + 1;
+        t->id = (sched_id_t)((slot_gen[i] << SLOT_BITS) | (i + 1));
+        t->deadline = deadline;
+        t->interval = interval;
+        t->epoch = run_epoch;
+        t->fn = fn;
+        t->ctx = ctx;
+        return t->id;
+    }
+    return SCHED_NONE;
+}
+
+static sched_task_t *find_task(sched_id_t id) {
+    int slot = (id & SLOT_MASK) - 1;
+    if (id <= SCHED_NONE || slot < 0 || slot >= SCHED_MAX_TASKS) return NULL;
+    return tasks[slot].id == id ? &tasks[slot] : NULL;
+}
+
+sched_id_t sched_every(uint64_t interval_us, sched_fn_t fn, void *ctx) {
+    if (interval_us == 0) return SCHED_NONE; //would never leave sched_run
+    return add_task(platform_time_us() + interval_us, interval_us, fn, ctx);
+}
+
+sched_id_t sched_at(uint64_t deadline_us, sched_fn_t fn, void *ctx) {
+    return add_task(deadline_us ? deadline_us : 1, 0, fn, ctx);
+}
+
+sched_id_t sched_after(uint64_t delay_us, sched_fn_t fn, void *ctx) {
+    return sched_at(platform_time_us() + delay_us, fn, ctx);
+}
+
+sched_id_t sched_defer(sched_fn_t fn, void *ctx) {
+    return add_task(0, 0, fn, ctx);
+}
+
+sched_id_t sched_cancel(sched_id_t id) {
+    sched_task_t *t = find_task(id);
+    if (t) t->id = SCHED_NONE;
+    return SCHED_NONE;
+}
+
+int sched_pending(sched_id_t id) {
+    return find_task(id) != NULL;
+}
+
+void sched_run(void) {
+    uint64_t now = platform_time_us();
+    frame_us = run_now ? now - run_now : 0;
+    run_now = now;
+    unsigned int epoch = ++run_epoch; //anything added from here on waits a run
+
+    for (;;) {
+        sched_task_t *due = NULL;
+        for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+            sched_task_t *t = &tasks[i];
+            if (t->id == SCHED_NONE || t->epoch == epoch || t->deadline > now) continue;
+            if (!due || t->deadline < due->deadline) due = t;
+        }
+        if (!due) break;
+
+        //settle the slot first, the callback may cancel or reuse it
+        sched_fn_t fn = due->fn;
+        void *ctx = due->ctx;
+        if (due->interval) {
+            due->deadline += due->interval;
+            //too far behind to catch up, skip to the next tick in phase
+            if (due->deadline <= now && (now - due->deadline) / due->interval + 1 >= SCHED_MAX_CATCHUP) {
+                due->deadline += ((now - due->deadline) / due->interval + 1) * due->interval;
+            }
+        } else {
+            due->id = SCHED_NONE;
+        }
+        fn(ctx);
+    }
+}
+
+uint64_t sched_now(void) {
+    return run_now;
+}
+
+uint64_t sched_frame_us(void) {
+    return frame_us;
+}
+
+uint32_t sched_idle_us(uint32_t max_us) {
+    uint64_t now = platform_time_us();
+    uint64_t wait = max_us;
+    for (int i = 0; i < SCHED_MAX_TASKS; i++) {
+        const sched_task_t *t = &tasks[i];
+        if (t->id == SCHED_NONE) continue;
+        if (t->deadline <= now) return 0;
+        if (t->deadline - now < wait) wait = t->deadline - now;
+    }
+    return (uint32_t)wait;
+}
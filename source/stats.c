@@ -0,0 +1,107 @@
+#include "stats.h"
+#include "csv.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define STATS_DELIMITER ','
+#define STATS_FIELDS    3
+
+typedef struct {
+    const char *fields[STATS_FIELDS];
+    stats_row_cb cb;
+    void *ctx;
+    size_t rows;
+} stats_reader_t;
+
+static int stats_field(const char *field, size_t len, size_t col, void *ctx) {
+    stats_reader_t *r = ctx;
+    if (col < STATS_FIELDS) r->fields[col] = field;
+    return 1;
+}
+
+static int stats_row(size_t index, size_t field_count, void *ctx) {
+    stats_reader_t *r = ctx;
+    if (field_count != STATS_FIELDS || !r->fields[0][0]) return 1; //blank or torn row
+
+    char *end;
+    long long last_used = strtoll(r->fields[1], &end, 10);
+    if (*end) return 1;
+    long use_count = strtol(r->fields[2], &end, 10);
+    if (*end || use_count < 0) return 1;
+
+    stats_entry_t entry = {r->fields[0], (time_t)last_used, (int)use_count};
+    r->rows++;
+    return r->cb(&entry, r->ctx);
+}
+
+int stats_load(const char *path, stats_row_cb cb, void *ctx, size_t *rows_out) {
+    if (rows_out) *rows_out = 0;
+    if (!path || !cb) return 0;
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 1; //nothing recorded yet
+    fclose(fp);
+
+    stats_reader_t r = {{NULL}, cb, ctx, 0};
+    int ok = csv_parse_stream(path, STATS_DELIMITER, stats_field, stats_row, &r);
+    if (rows_out) *rows_out = r.rows;
+    return ok;
+}
+
+static int add_entry(CSVBuffer *buf, const stats_entry_t *entry) {
+    char last_used[24];
+    char use_count[16];
+    snprintf(last_used, sizeof(last_used), "%lld", (long long)entry->last_used);
+    snprintf(use_count, sizeof(use_count), "%d", entry->use_count);
+    char *fields[] = {(char *)entry->name, last_used, use_count};
+    return csv_buffer_add_row(buf, fields, STATS_FIELDS, STATS_DELIMITER);
+}
+
+int stats_append(const char *path, const stats_entry_t *entry) {
+    if (!path || !entry || !entry->name) return 0;
+    CSVBuffer buf = {0};
+    int ok = add_entry(&buf, entry) && csv_append_buffer(path, &buf);
+    csv_buffer_free(&buf);
+    return ok;
+}
+
+int stats_rewrite(const char *path, const stats_entry_t *entries, size_t count) {
+    if (!path) return 0;
+
+    CSVBuffer buf = {0};
+    for (size_t i = 0; i < count; i++) {
+        if (!add_entry(&buf, &entries[i])) {
+            csv_buffer_free(&buf);
+            return 0;
+        }
+    }
+
+    size_t len = strlen(path);
+    char *tmp = malloc(len + 5);
+    if (!tmp) {
+        csv_buffer_free(&buf);
+        return 0;
+    }
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+
+    int ok = 0;
+    FILE *fp = fopen(tmp, "w");
+    if (fp) {
+        size_t written = buf.len ? fwrite(buf.data, 1, buf.len, fp) : 0;
+        ok = fclose(fp) == 0 && written == buf.len;
+        if (ok) {
+            unlink(path); //rename won't replace an existing file on every fs
+            ok = rename(tmp, path) == 0;
+        } else {
+            unlink(tmp);
+        }
+    }
+
+    free(tmp);
+    csv_buffer_free(&buf);
+    return ok;
+}
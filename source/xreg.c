@@ -2,6 +2,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
 
 #define FILE_SIZE_EXPECTED 0x40000u
 #define AREA_SIZE 0x10000u
@@ -193,6 +195,119 @@ int xreg_update_value(xreg_registry_t *reg, const char *key_name,
     return update_value_in_buffer(reg->buffer, reg->size, val, new_data, new_len);
 }
 
+//bool and int values are stored big endian in 1-4 bytes
+static int value_is_number(const xreg_value_t *val) {
+    return (val->value_type == 0 || val->value_type == 1) && val->value_length >= 1 && val->value_length <= 4;
+}
+
+static xreg_value_t *find_value(const xreg_registry_t *reg, const char *key_name) {
+    return xreg_find_value_by_key(reg, xreg_find_key(reg, key_name));
+}
+
+int xreg_get_text(const xreg_registry_t *reg, const char *key_name, char *out, size_t out_size) {
+    if (!out || out_size == 0) return 0;
+    xreg_value_t *val = find_value(reg, key_name);
+    if (!val) return 0;
+
+    if (value_is_number(val)) {
+        uint32_t v = 0;
+        for (size_t i = 0; i < val->value_length; i++) v = (v << 8) | val->value_data[i];
+        if (val->value_length == 4) return snprintf(out, out_size, "%ld", (long)(int32_t)v) < (int)out_size;
+        return snprintf(out, out_size, "%lu", (unsigned long)v) < (int)out_size;
+    }
+    if (val->value_type == 2) {
+        size_t len = 0;
+        while (len < val->value_length && val->value_data[len] != '\0') len++;
+        if (len >= out_size) return 0;
+        memcpy(out, val->value_data, len);
+        out[len] = '\0';
+        return 1;
+    }
+    return 0;
+}
+
+long xreg_text_capacity(const xreg_registry_t *reg, const char *key_name) {
+    xreg_value_t *val = find_value(reg, key_name);
+    if (!val || val->value_type != 2) return -1;
+    return val->value_length;
+}
+
+//encode text for val's type into out (value_length bytes). returns bytes used or -1.
+//numbers must fit the width the way xreg_get_text prints them back: 4 bytes
+//signed, 1-3 unsigned, so 300 is refused for a 1 byte bool instead of wrapping
+static long encode_text(const xreg_value_t *val, const char *text, uint8_t *out) {
+    if (value_is_number(val)) {
+        char *end;
+        errno = 0;
+        long long v = strtoll(text, &end, 10);
+        if (!*text || *end || errno == ERANGE) return -1;
+        long long lo = val->value_length == 4 ? INT32_MIN : 0;
+        long long hi = val->value_length == 4 ? INT32_MAX : (1LL << (8 * val->value_length)) - 1;
+        if (v < lo || v > hi) return -1;
+        for (int i = val->value_length - 1; i >= 0; i--) {
+            out[i] = (uint8_t)(v & 0xFF);
+            v >>= 8;
+        }
+        return val->value_length;
+    }
+    if (val->value_type == 2) {
+        size_t len = strlen(text);
+        if (len > val->value_length) return -1; //cant grow in place
+        memcpy(out, text, len);
+        return (long)len;
+    }
+    return -1;
+}
+
+int xreg_update_batch(xreg_registry_t *reg, const xreg_write_t *writes, size_t count) {
+    if (!reg || (count && !writes)) return 0;
+
+    //resolve every key and size the scratch buffer
+    size_t max_len = 1;
+    for (size_t i = 0; i < count; i++) {
+        xreg_value_t *val = find_value(reg, writes[i].key_name);
+        if (!val || !writes[i].text) return 0;
+        if (!within_bounds(val->file_offset + 9, val->value_length + 1, reg->size)) return 0;
+        if (val->value_length > max_len) max_len = val->value_length;
+    }
+
+    uint8_t *scratch = malloc(max_len);
+    if (!scratch) return 0;
+
+    int ok = 1;
+    for (size_t i = 0; ok && i < count; i++) {
+        ok = encode_text(find_value(reg, writes[i].key_name), writes[i].text, scratch) >= 0;
+    }
+    for (size_t i = 0; ok && i < count; i++) {
+        xreg_value_t *val = find_value(reg, writes[i].key_name);
+        long len = encode_text(val, writes[i].text, scratch);
+        ok = update_value_in_buffer(reg->buffer, reg->size, val, scratch, (size_t)len);
+    }
+
+    free(scratch);
+    return ok;
+}
+
+long xreg_filter_unchanged(const xreg_registry_t *reg, xreg_write_t *writes, size_t count) {
+    if (!reg || (count && !writes)) return -1;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++) {
+        xreg_value_t *val = find_value(reg, writes[i].key_name);
+        if (!val || !writes[i].text) return -1;
+
+        uint8_t *encoded = calloc(val->value_length ? val->value_length : 1, 1); //zero padded like the write
+        if (!encoded) return -1;
+        long len = encode_text(val, writes[i].text, encoded);
+        int same = len >= 0 && memcmp(encoded, val->value_data, val->value_length) == 0;
+        free(encoded);
+        if (len < 0) return -1;
+
+        if (!same) writes[kept++] = writes[i];
+    }
+    return (long)kept;
+}
+
 xreg_registry_t *xreg_load(const char *path) {
     FILE *f = fopen(path, "rb");
     if (!f) return NULL;
@@ -228,8 +343,10 @@ int xreg_save(const xreg_registry_t *reg, const char *path) {
     FILE *f = fopen(path, "wb");
     if (!f) return 0;
     size_t written = fwrite(reg->buffer, 1, reg->size, f);
-    fclose(f);
-    return written == reg->size;
+    //only report success once the bytes are on flash, callers reboot right after
+    int synced = fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if (fclose(f) != 0) synced = 0;
+    return written == reg->size && synced;
 }
 
 void xreg_free(xreg_registry_t *reg) {